@@ -59,5 +59,12 @@ final class PhotoEntityController: EntityController {
 
     private func deleteMediaFile(for media: PhotoEntity) throws {
         try FileManager.default.removeItem(atPath: media.absoluteFilePath)
+        try? FileManager.default.removeItem(atPath: media.absoluteOriginalFilePath)
+
+        let checkpointFileNames = (try? FileManager.default.contentsOfDirectory(
+            atPath: media.checkpointsDirectoryURL.path)) ?? []
+        for checkpointFileName in checkpointFileNames where checkpointFileName.hasPrefix(media.checkpointFileNamePrefix) {
+            try? FileManager.default.removeItem(atPath: media.absoluteCheckpointFilePath(fileName: checkpointFileName))
+        }
     }
 }
@@ -23,6 +23,7 @@ public extension ImageProjectEntity {
     @NSManaged var frameWidth: NSNumber?
     @NSManaged var frameHeight: NSNumber?
     @NSManaged var backgroundColorHex: String
+    @NSManaged var pixelPrecision: String?
 }
 
 extension ImageProjectEntity: Identifiable {
@@ -32,7 +33,7 @@ extension ImageProjectEntity: Identifiable {
                      backgroundColorHex: String = "#FFFFFF00",
                      mediaEntities: Set<PhotoEntity>? = Set<PhotoEntity>())
     {
-        self.init(context: PersistenceController.shared.container.viewContext)
+        self.init(context: PersistenceController.shared.viewContext)
         self.id = id
         self.title = title
         self.lastEditDate = lastEditDate
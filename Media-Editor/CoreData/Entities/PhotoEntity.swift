@@ -24,6 +24,9 @@ public extension PhotoEntity {
     @NSManaged var scaleY: NSNumber?
     @NSManaged var rotation: NSNumber?
     @NSManaged var toDelete: Bool
+    @NSManaged var blendMode: String?
+    @NSManaged var opacity: Double
+    @NSManaged var editStack: Data?
 
     @NSManaged var photoEntityToImageProjectEntity: ImageProjectEntity?
     @NSManaged var photoEntityToTextModelEntity: TextModelEntity?
@@ -39,7 +42,7 @@ extension PhotoEntity: Identifiable {
                      positionY: Double = 0.0,
                      positionZ: Int? = nil)
     {
-        self.init(context: PersistenceController.shared.container.viewContext)
+        self.init(context: PersistenceController.shared.viewContext)
         self.fileName = fileName
         self.photoEntityToImageProjectEntity = projectEntity
         self.positionX = NSNumber(value: positionX)
@@ -70,4 +73,36 @@ extension PhotoEntity {
             .absoluteString
             .replacingOccurrences(of: "file://", with: "")
     }
+
+    var absoluteOriginalFilePath: String {
+        let originalsDirectoryPath: URL =
+            FileManager
+                .default
+                .urls(for: .documentDirectory, in: .userDomainMask)
+                .first!
+                .appendingPathComponent("UserMediaOriginals")
+        return originalsDirectoryPath
+            .appendingPathComponent(self.fileName!)
+            .absoluteString
+            .replacingOccurrences(of: "file://", with: "")
+    }
+
+    var checkpointsDirectoryURL: URL {
+        return FileManager
+            .default
+            .urls(for: .documentDirectory, in: .userDomainMask)
+            .first!
+            .appendingPathComponent("UserMediaCheckpoints")
+    }
+
+    var checkpointFileNamePrefix: String {
+        return (self.fileName! as NSString).deletingPathExtension + "-"
+    }
+
+    func absoluteCheckpointFilePath(fileName: String) -> String {
+        return checkpointsDirectoryURL
+            .appendingPathComponent(fileName)
+            .absoluteString
+            .replacingOccurrences(of: "file://", with: "")
+    }
 }
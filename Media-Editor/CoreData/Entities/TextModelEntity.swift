@@ -38,7 +38,7 @@ extension TextModelEntity: Identifiable {
                      borderSize: Int = 0,
                      textModelEntityToPhotoEntity: PhotoEntity? = nil)
     {
-        self.init(context: PersistenceController.shared.container.viewContext)
+        self.init(context: PersistenceController.shared.viewContext)
         self.id = id
         self.text = text
         self.fontName = fontName
@@ -5,23 +5,30 @@
 //  Created by Łukasz Bielawski on 06/01/2024.
 //
 
+import Combine
 import CoreData
 import Foundation
+import UIKit
 
 class PersistenceController {
     var container: NSPersistentContainer
 
     static let shared = PersistenceController()
 
+    // Models edit the main-queue context; its saves only push into the private-queue
+    // writer, which does the SQLite work off the main thread.
+    let viewContext: NSManagedObjectContext
+    private let writerContext: NSManagedObjectContext
+
     let projectController: ProjectEntityController
     let photoController: PhotoEntityController
 
-    private init(inMemory: Bool = false) {
-        container = NSPersistentContainer(name: "Model")
+    private let saveSubject = PassthroughSubject<Void, Never>()
+    private var cancellables = Set<AnyCancellable>()
+    private var transactionDepth = 0
 
-        let context = container.viewContext
-        projectController = ProjectEntityController(context: context)
-        photoController = PhotoEntityController(context: context)
+    private init(inMemory: Bool = false, saveDebounceInterval: TimeInterval = 1.0) {
+        container = NSPersistentContainer(name: "Model")
 
         if inMemory {
             container.persistentStoreDescriptions.first?.url = URL(fileURLWithPath: "/dev/null")
@@ -32,17 +39,86 @@ class PersistenceController {
                 fatalError("Unresolved error \(error)")
             }
         }
+
+        writerContext = container.newBackgroundContext()
+        writerContext.mergePolicy = NSMergeByPropertyObjectTrumpMergePolicy
+
+        viewContext = NSManagedObjectContext(concurrencyType: .mainQueueConcurrencyType)
+        viewContext.parent = writerContext
+        viewContext.mergePolicy = NSMergeByPropertyObjectTrumpMergePolicy
+        viewContext.automaticallyMergesChangesFromParent = true
+
+        projectController = ProjectEntityController(context: viewContext)
+        photoController = PhotoEntityController(context: viewContext)
+
+        saveSubject
+            .debounce(for: .seconds(saveDebounceInterval), scheduler: DispatchQueue.main)
+            .sink { [unowned self] in
+                self.saveChanges()
+            }
+            .store(in: &cancellables)
+
+        NotificationCenter.default
+            .publisher(for: UIApplication.willResignActiveNotification)
+            .sink { [unowned self] _ in
+                self.saveChanges(waitsForWriter: true)
+            }
+            .store(in: &cancellables)
     }
 
-    func saveChanges() {
-        if container.viewContext.hasChanges {
+    // Bursts of edits are coalesced into a single save once editing goes quiet.
+    func scheduleSave() {
+        saveSubject.send()
+    }
+
+    // The writer normally saves asynchronously; on resign it is waited for, since the app may be
+    // suspended before a queued save gets to run.
+    func saveChanges(waitsForWriter: Bool = false) {
+        guard transactionDepth == 0 else { return }
+
+        if viewContext.hasChanges {
             do {
-                try container.viewContext.save()
+                try viewContext.obtainPermanentIDs(for: Array(viewContext.insertedObjects))
+                try viewContext.save()
             } catch {
                 let nserror = error as NSError
                 print("Unresolved error \(nserror), \(nserror.userInfo)")
+                return
             }
         }
+
+        let saveWriterContext = { [writerContext] in
+            guard writerContext.hasChanges else { return }
+            do {
+                try writerContext.save()
+            } catch {
+                let nserror = error as NSError
+                print("Unresolved error \(nserror), \(nserror.userInfo)")
+            }
+        }
+
+        if waitsForWriter {
+            writerContext.performAndWait(saveWriterContext)
+        } else {
+            writerContext.perform(saveWriterContext)
+        }
+    }
+
+    // Multi-entity edits are saved once, at the end of the outermost transaction.
+    func performTransaction<T>(_ changes: () throws -> T) rethrows -> T {
+        transactionDepth += 1
+
+        let result: T
+        do {
+            result = try changes()
+        } catch {
+            transactionDepth -= 1
+            throw error
+        }
+
+        transactionDepth -= 1
+        saveChanges()
+        return result
     }
 
     static var preview: PersistenceController = {
@@ -0,0 +1,68 @@
+//
+//  BlendModeType.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 19/07/2024.
+//
+
+import SwiftUI
+
+enum BlendModeType: String, CaseIterable, Identifiable {
+    case normal
+    case multiply
+    case screen
+    case overlay
+    case softLight
+    case darken
+    case lighten
+    case difference
+    case destinationOut
+
+    var id: String { return rawValue }
+
+    var name: String {
+        switch self {
+        case .normal:
+            "Normal"
+        case .multiply:
+            "Multiply"
+        case .screen:
+            "Screen"
+        case .overlay:
+            "Overlay"
+        case .softLight:
+            "Soft Light"
+        case .darken:
+            "Darken"
+        case .lighten:
+            "Lighten"
+        case .difference:
+            "Difference"
+        case .destinationOut:
+            "Cut Out"
+        }
+    }
+
+    var blendMode: BlendMode {
+        switch self {
+        case .normal:
+            .normal
+        case .multiply:
+            .multiply
+        case .screen:
+            .screen
+        case .overlay:
+            .overlay
+        case .softLight:
+            .softLight
+        case .darken:
+            .darken
+        case .lighten:
+            .lighten
+        case .difference:
+            .difference
+        case .destinationOut:
+            .destinationOut
+        }
+    }
+}
@@ -0,0 +1,27 @@
+//
+//  CacheTierType.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 26/07/2024.
+//
+
+import Foundation
+
+// Ordered by eviction priority: lower tiers are dropped first.
+enum CacheTierType: Int, CaseIterable, Comparable {
+    case preview
+    case renderGraph
+    case thumbnail
+    case snapshot
+
+    static func < (lhs: CacheTierType, rhs: CacheTierType) -> Bool {
+        return lhs.rawValue < rhs.rawValue
+    }
+}
+
+extension CacheTierType {
+    // Snapshot bitmaps can be replayed from the edit stack, but only at the cost of a full render.
+    var isRegenerable: Bool {
+        return self != .snapshot
+    }
+}
@@ -31,4 +31,13 @@ enum ColorPickerType {
             .gradient
         }
     }
+
+    var allowsProjectSampling: Bool {
+        switch self {
+        case .projectBackground, .textColor, .borderColor:
+            true
+        case .layerBackground, .pencilColor, .bucketColorPicker:
+            false
+        }
+    }
 }
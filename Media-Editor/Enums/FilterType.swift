@@ -642,7 +642,7 @@ enum FilterType: CaseIterable, Equatable {
         let filter = CIFilter(name: filterName)
         filter?.setValue(image, forKey: kCIInputImageKey)
 
-        let sizeCorrectionFactor = hypot(image.extent.size.width, image.extent.size.height) / referenceDiagonalWidth
+        let sizeCorrectionFactor = self.sizeCorrectionFactor(for: image.extent.size)
 
         switch self {
         case .gaussianBlur(let value):
@@ -745,4 +745,48 @@ extension FilterType: Identifiable {
     var referenceDiagonalWidth: CGFloat {
         return hypot(3000, 2000)
     }
+
+    func sizeCorrectionFactor(for size: CGSize) -> CGFloat {
+        return hypot(size.width, size.height) / referenceDiagonalWidth
+    }
+
+    var parameterValue: CGFloat? {
+        return switch self {
+        case .gaussianBlur(let value),
+             .discBlur(let value),
+             .motionBlur(let value),
+             .zoomBlur(let value),
+             .brightness(let value),
+             .contrast(let value),
+             .saturation(let value),
+             .exposure(let value),
+             .sharpness(let value),
+             .gamma(let value),
+             .vibrance(let value),
+             .temperature(let value),
+             .bump(let value),
+             .bumpLinear(let value),
+             .circleSplash(let value),
+             .glass(let value),
+             .lightTunnel(let value),
+             .edgeWork(let value),
+             .lineOverlay(let value),
+             .pixellate(let value),
+             .crystalize(let value):
+            value
+
+        case .fade,
+             .instant,
+             .mono,
+             .noir,
+             .process,
+             .sepia,
+             .chrome,
+             .tonal,
+             .transfer,
+             .comic,
+             .colorInvert:
+            nil
+        }
+    }
 }
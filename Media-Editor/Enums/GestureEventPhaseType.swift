@@ -0,0 +1,13 @@
+//
+//  GestureEventPhaseType.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 11/04/2024.
+//
+
+import Foundation
+
+enum GestureEventPhaseType {
+    case frame
+    case settle
+}
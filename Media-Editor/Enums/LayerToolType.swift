@@ -14,6 +14,7 @@ enum LayerToolType: String, Tool {
     case background
     case magicWand
     case flip
+    case blend
     case editText
 
     var id: String { return rawValue }
@@ -34,6 +35,8 @@ extension LayerToolType {
             return "Magic Wand"
         case .flip:
             return "Flip"
+        case .blend:
+            return "Blend"
         case .editText:
             return "Edit text"
         }
@@ -53,6 +56,8 @@ extension LayerToolType {
             return "wand.and.stars.inverse"
         case .flip:
             return "arrowtriangle.left.and.line.vertical.and.arrowtriangle.right.fill"
+        case .blend:
+            return "square.3.layers.3d.top.filled"
         case .editText:
             return "character.cursor.ibeam"
         }
@@ -72,6 +77,8 @@ extension LayerToolType {
             true
         case .flip:
             false
+        case .blend:
+            false
         case .editText:
             false
         }
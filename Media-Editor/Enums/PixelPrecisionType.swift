@@ -0,0 +1,93 @@
+//
+//  PixelPrecisionType.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 22/07/2024.
+//
+
+import CoreGraphics
+import CoreImage
+
+enum PixelPrecisionType: String, CaseIterable {
+    case eight
+    case sixteen
+    case halfFloat
+}
+
+extension PixelPrecisionType {
+    var toString: String {
+        switch self {
+        case .eight:
+            "8-bit"
+        case .sixteen:
+            "16-bit"
+        case .halfFloat:
+            "Half Float"
+        }
+    }
+
+    var bitsPerComponent: Int {
+        return self == .eight ? 8 : 16
+    }
+
+    var bytesPerPixel: Int {
+        return bitsPerComponent / 2
+    }
+
+    var bitmapInfo: UInt32 {
+        switch self {
+        case .eight:
+            CGImageAlphaInfo.premultipliedLast.rawValue
+        case .sixteen:
+            CGImageAlphaInfo.premultipliedLast.rawValue | CGBitmapInfo.byteOrder16Little.rawValue
+        case .halfFloat:
+            CGImageAlphaInfo.premultipliedLast.rawValue | CGBitmapInfo.byteOrder16Little.rawValue
+                | CGBitmapInfo.floatComponents.rawValue
+        }
+    }
+
+    var ciFormat: CIFormat {
+        switch self {
+        case .eight:
+            .RGBA8
+        case .sixteen:
+            .RGBA16
+        case .halfFloat:
+            .RGBAh
+        }
+    }
+
+    init(cgImage: CGImage) {
+        if cgImage.bitsPerComponent <= 8 {
+            self = .eight
+        } else {
+            self = cgImage.bitmapInfo.contains(.floatComponents) ? .halfFloat : .sixteen
+        }
+    }
+
+    init(context: CGContext) {
+        if context.bitsPerComponent <= 8 {
+            self = .eight
+        } else {
+            self = context.bitmapInfo.contains(.floatComponents) ? .halfFloat : .sixteen
+        }
+    }
+
+    func deeper(than other: PixelPrecisionType) -> PixelPrecisionType {
+        return bitsPerComponent >= other.bitsPerComponent ? self : other
+    }
+
+    func createContext(width: Int,
+                       height: Int,
+                       data: UnsafeMutableRawPointer? = nil,
+                       colorSpace: CGColorSpace = ColorManagementService.shared.workingColorSpace) -> CGContext?
+    {
+        return CGContext(data: data,
+                         width: width,
+                         height: height,
+                         bitsPerComponent: bitsPerComponent,
+                         bytesPerRow: data == nil ? 0 : width * bytesPerPixel,
+                         space: colorSpace,
+                         bitmapInfo: bitmapInfo)
+    }
+}
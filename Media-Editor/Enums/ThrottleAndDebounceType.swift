@@ -1,13 +0,0 @@
-//
-//  ThrottleAndDebounceType.swift
-//  Media-Editor
-//
-//  Created by Łukasz Bielawski on 11/04/2024.
-//
-
-import Foundation
-
-enum ThrottleAndDebounceType {
-    case throttle
-    case debounce
-}
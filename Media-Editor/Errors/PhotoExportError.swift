@@ -15,5 +15,6 @@ enum PhotoExportError: Error {
     case dataRetrieving
     case fontCreating
     case noCGImageInLayer
+    case unsupportedFilter
     case other
 }
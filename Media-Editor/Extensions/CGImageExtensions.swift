@@ -9,6 +9,10 @@ import Foundation
 import UIKit
 
 extension CGImage {
+    var byteCost: Int {
+        return bytesPerRow * height
+    }
+
     func cropImageByAlpha() -> CGImage {
         let context = self.createARGBBitmapContextFromImage()
         let height = self.height
@@ -128,7 +132,7 @@ extension CGImage {
         let bitmapBytesPerRow = width * 4
         let bitmapByteCount = bitmapBytesPerRow * height
 
-        let colorSpace = CGColorSpaceCreateDeviceRGB()
+        let colorSpace = ColorManagementService.shared.workingColorSpace
 
         let bitmapData = malloc(bitmapByteCount)
         if bitmapData == nil {
@@ -0,0 +1,25 @@
+//
+//  DispatchQueueExtensions.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 08/07/2024.
+//
+
+import Foundation
+
+extension DispatchQueue {
+    static func concurrentPerform(rowCount: Int, minimumRowsPerBand: Int = 16, execute work: (Range<Int>) -> Void) {
+        guard rowCount > 0 else { return }
+
+        let bandCount = max(1, min(ProcessInfo.processInfo.activeProcessorCount * 4,
+                                   rowCount / max(minimumRowsPerBand, 1)))
+        let rowsPerBand = (rowCount + bandCount - 1) / bandCount
+
+        concurrentPerform(iterations: bandCount) { band in
+            let startRow = band * rowsPerBand
+            let endRow = min(startRow + rowsPerBand, rowCount)
+            guard startRow < endRow else { return }
+            work(startRow ..< endRow)
+        }
+    }
+}
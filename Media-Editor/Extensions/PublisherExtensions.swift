@@ -8,16 +8,21 @@
 import Combine
 import Foundation
 
-extension Publisher {
-    func throttleAndDebounce<S>(throttleInterval: S.SchedulerTimeType.Stride, debounceInterval: S.SchedulerTimeType.Stride, scheduler: S) -> AnyPublisher<(Output, ThrottleAndDebounceType), Failure> where S: Scheduler {
-        return self
-            .debounce(for: debounceInterval, scheduler: scheduler)
-            .map { ($0, .debounce) }
-            .merge(with:
-                self
-                    .map { ($0, .throttle) }
-                    .throttle(for: throttleInterval, scheduler: scheduler, latest: true)
-            )
-            .eraseToAnyPublisher()
+extension Publisher where Failure == Never {
+    // Must be subscribed from the main thread; values are coalesced onto display frames.
+    func coalescedPerFrame(settleInterval: TimeInterval, label: String? = nil)
+        -> AnyPublisher<(Output, GestureEventPhaseType), Never>
+    {
+        return Deferred {
+            let coalescer = FrameCoalescer<Output>(settleInterval: settleInterval, label: label)
+
+            return coalescer.subject
+                .merge(with: self
+                    .handleEvents(receiveOutput: { coalescer.receive($0) },
+                                  receiveCancel: { coalescer.invalidate() })
+                    .flatMap { _ in Empty<(Output, GestureEventPhaseType), Never>() })
+                .handleEvents(receiveCancel: { coalescer.invalidate() })
+        }
+        .eraseToAnyPublisher()
     }
 }
@@ -11,4 +11,5 @@ struct CGLinearGradient {
     let cgGradient: CGGradient?
     let startPoint: UnitPoint
     let endPoint: UnitPoint
+    let lookupTable: GradientLookupTable
 }
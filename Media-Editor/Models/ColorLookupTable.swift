@@ -0,0 +1,132 @@
+//
+//  ColorLookupTable.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 10/07/2024.
+//
+
+import Foundation
+
+final class ColorLookupTable {
+    static let fileMagic: [UInt8] = Array("MLUT".utf8)
+    static let fileVersion: UInt16 = 1
+
+    let dimension: Int
+    let values: [SIMD4<Float>]
+
+    init(dimension: Int, values: [SIMD4<Float>]) {
+        self.dimension = dimension
+        self.values = values
+    }
+
+    convenience init(data: Data) throws {
+        let headerSize = ColorLookupTable.fileMagic.count + 2 * MemoryLayout<UInt16>.size
+        guard data.count >= headerSize,
+              Array(data.prefix(ColorLookupTable.fileMagic.count)) == ColorLookupTable.fileMagic
+        else { throw PhotoExportError.dataRetrieving }
+
+        let words = data.withUnsafeBytes { rawBuffer in
+            (0 ..< (rawBuffer.count - ColorLookupTable.fileMagic.count) / 2).map { index in
+                UInt16(littleEndian: rawBuffer.loadUnaligned(fromByteOffset: ColorLookupTable.fileMagic.count + index * 2,
+                                                             as: UInt16.self))
+            }
+        }
+
+        let version = words[0]
+        let dimension = Int(words[1])
+        let valueCount = dimension * dimension * dimension
+
+        guard version == ColorLookupTable.fileVersion,
+              dimension > 1,
+              words.count >= 2 + valueCount * 3
+        else { throw PhotoExportError.dataRetrieving }
+
+        let values = (0 ..< valueCount).map { index in
+            SIMD4<Float>(Float(words[2 + index * 3]),
+                         Float(words[3 + index * 3]),
+                         Float(words[4 + index * 3]),
+                         Float(UInt16.max)) / Float(UInt16.max)
+        }
+
+        self.init(dimension: dimension, values: values)
+    }
+
+    var binaryRepresentation: Data {
+        var data = Data(ColorLookupTable.fileMagic)
+        var words: [UInt16] = [ColorLookupTable.fileVersion, UInt16(dimension)]
+        words.reserveCapacity(2 + values.count * 3)
+
+        for value in values {
+            let quantizedValue = (value * Float(UInt16.max)).rounded()
+                .clamped(lowerBound: .zero, upperBound: SIMD4(repeating: Float(UInt16.max)))
+            words.append(UInt16(quantizedValue.x))
+            words.append(UInt16(quantizedValue.y))
+            words.append(UInt16(quantizedValue.z))
+        }
+
+        words.withUnsafeBufferPointer { buffer in
+            for word in buffer {
+                withUnsafeBytes(of: word.littleEndian) { data.append(contentsOf: $0) }
+            }
+        }
+        return data
+    }
+
+    @inline(__always)
+    func tetrahedralLookup(_ color: SIMD4<Float>, in values: UnsafeBufferPointer<SIMD4<Float>>) -> SIMD4<Float> {
+        let maxIndex = Float(dimension - 1)
+        let scaledColor = (color * maxIndex).clamped(lowerBound: .zero, upperBound: SIMD4(repeating: maxIndex))
+
+        let red = min(Int(scaledColor.x), dimension - 2)
+        let green = min(Int(scaledColor.y), dimension - 2)
+        let blue = min(Int(scaledColor.z), dimension - 2)
+
+        let fractionRed = scaledColor.x - Float(red)
+        let fractionGreen = scaledColor.y - Float(green)
+        let fractionBlue = scaledColor.z - Float(blue)
+
+        let redStride = 1
+        let greenStride = dimension
+        let blueStride = dimension * dimension
+        let base = blue * blueStride + green * greenStride + red
+
+        let c000 = values[base]
+        let c111 = values[base + redStride + greenStride + blueStride]
+
+        if fractionRed > fractionGreen {
+            if fractionGreen > fractionBlue {
+                return c000 * (1.0 - fractionRed)
+                    + values[base + redStride] * (fractionRed - fractionGreen)
+                    + values[base + redStride + greenStride] * (fractionGreen - fractionBlue)
+                    + c111 * fractionBlue
+            } else if fractionRed > fractionBlue {
+                return c000 * (1.0 - fractionRed)
+                    + values[base + redStride] * (fractionRed - fractionBlue)
+                    + values[base + redStride + blueStride] * (fractionBlue - fractionGreen)
+                    + c111 * fractionGreen
+            } else {
+                return c000 * (1.0 - fractionBlue)
+                    + values[base + blueStride] * (fractionBlue - fractionRed)
+                    + values[base + redStride + blueStride] * (fractionRed - fractionGreen)
+                    + c111 * fractionGreen
+            }
+        } else {
+            if fractionBlue > fractionGreen {
+                return c000 * (1.0 - fractionBlue)
+                    + values[base + blueStride] * (fractionBlue - fractionGreen)
+                    + values[base + greenStride + blueStride] * (fractionGreen - fractionRed)
+                    + c111 * fractionRed
+            } else if fractionBlue > fractionRed {
+                return c000 * (1.0 - fractionGreen)
+                    + values[base + greenStride] * (fractionGreen - fractionBlue)
+                    + values[base + greenStride + blueStride] * (fractionBlue - fractionRed)
+                    + c111 * fractionRed
+            } else {
+                return c000 * (1.0 - fractionGreen)
+                    + values[base + greenStride] * (fractionGreen - fractionRed)
+                    + values[base + redStride + greenStride] * (fractionRed - fractionBlue)
+                    + c111 * fractionBlue
+            }
+        }
+    }
+}
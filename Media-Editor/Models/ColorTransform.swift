@@ -0,0 +1,171 @@
+//
+//  ColorTransform.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 23/07/2024.
+//
+
+import CoreGraphics
+import Foundation
+import simd
+
+final class ColorTransform {
+    struct Profile {
+        enum TransferFunction {
+            case sRGB
+            case gamma(Float)
+            case linear
+        }
+
+        let primaries: (red: SIMD2<Float>, green: SIMD2<Float>, blue: SIMD2<Float>)
+        let whitePoint: SIMD2<Float>
+        let transferFunction: TransferFunction
+
+        static let d65WhitePoint = SIMD2<Float>(0.3127, 0.3290)
+
+        static let sRGB = Profile(primaries: (red: SIMD2(0.640, 0.330),
+                                              green: SIMD2(0.300, 0.600),
+                                              blue: SIMD2(0.150, 0.060)),
+                                  transferFunction: .sRGB)
+
+        static let displayP3 = Profile(primaries: (red: SIMD2(0.680, 0.320),
+                                                   green: SIMD2(0.265, 0.690),
+                                                   blue: SIMD2(0.150, 0.060)),
+                                       transferFunction: .sRGB)
+
+        static let adobeRGB = Profile(primaries: (red: SIMD2(0.640, 0.330),
+                                                  green: SIMD2(0.210, 0.710),
+                                                  blue: SIMD2(0.150, 0.060)),
+                                      transferFunction: .gamma(563.0 / 256.0))
+
+        // Only named spaces with known primaries and curves are compiled. Anything else,
+        // such as an embedded camera ICC profile, falls back to a one-off Core Graphics conversion.
+        private static let namedProfiles: [CFString: Profile] = [
+            CGColorSpace.sRGB: .sRGB,
+            CGColorSpace.extendedSRGB: .sRGB,
+            CGColorSpace.linearSRGB: sRGB.linearized,
+            CGColorSpace.extendedLinearSRGB: sRGB.linearized,
+            CGColorSpace.displayP3: .displayP3,
+            CGColorSpace.extendedDisplayP3: .displayP3,
+            CGColorSpace.linearDisplayP3: displayP3.linearized,
+            CGColorSpace.adobeRGB1998: .adobeRGB
+        ]
+
+        init(primaries: (red: SIMD2<Float>, green: SIMD2<Float>, blue: SIMD2<Float>),
+             transferFunction: TransferFunction)
+        {
+            self.primaries = primaries
+            self.whitePoint = Self.d65WhitePoint
+            self.transferFunction = transferFunction
+        }
+
+        init?(colorSpace: CGColorSpace) {
+            guard colorSpace.model == .rgb,
+                  let name = colorSpace.name,
+                  let profile = Self.namedProfiles[name]
+            else { return nil }
+            self = profile
+        }
+
+        var linearized: Profile {
+            return Profile(primaries: primaries, transferFunction: .linear)
+        }
+
+        var rgbToXYZ: simd_float3x3 {
+            let xyz = { (chromaticity: SIMD2<Float>) in
+                SIMD3<Float>(chromaticity.x / chromaticity.y, 1.0, (1.0 - chromaticity.x - chromaticity.y) / chromaticity.y)
+            }
+
+            let primaryMatrix = simd_float3x3(xyz(primaries.red), xyz(primaries.green), xyz(primaries.blue))
+            let scale = primaryMatrix.inverse * xyz(whitePoint)
+
+            return simd_float3x3(primaryMatrix.columns.0 * scale.x,
+                                 primaryMatrix.columns.1 * scale.y,
+                                 primaryMatrix.columns.2 * scale.z)
+        }
+
+        func decode(_ value: Float) -> Float {
+            switch transferFunction {
+            case .sRGB:
+                value <= 0.04045 ? value / 12.92 : pow((value + 0.055) / 1.055, 2.4)
+            case .gamma(let gamma):
+                pow(value, gamma)
+            case .linear:
+                value
+            }
+        }
+
+        func encode(_ value: Float) -> Float {
+            switch transferFunction {
+            case .sRGB:
+                value <= 0.0031308 ? value * 12.92 : 1.055 * pow(value, 1.0 / 2.4) - 0.055
+            case .gamma(let gamma):
+                pow(value, 1.0 / gamma)
+            case .linear:
+                value
+            }
+        }
+    }
+
+    static let lookupTableSize = 4096
+
+    let matrix: simd_float3x3
+    let decodingTable: [Float]
+    let encodingTable: [Float]
+
+    init(from source: Profile, to destination: Profile) {
+        let lastIndex = Float(Self.lookupTableSize - 1)
+
+        self.matrix = destination.rgbToXYZ.inverse * source.rgbToXYZ
+        self.decodingTable = (0 ..< Self.lookupTableSize).map { source.decode(Float($0) / lastIndex) }
+        self.encodingTable = (0 ..< Self.lookupTableSize).map { destination.encode(Float($0) / lastIndex) }
+    }
+
+    // Pixels are unpremultiplied, decoded through the source curve, mapped between the
+    // primaries in linear light and re-encoded through the destination curve.
+    func apply(to buffer: PixelBuffer) {
+        let width = buffer.width
+        let matrix = matrix
+
+        decodingTable.withUnsafeBufferPointer { decodingTable in
+            encodingTable.withUnsafeBufferPointer { encodingTable in
+                DispatchQueue.concurrentPerform(rowCount: buffer.height) { rows in
+                    let row = UnsafeMutablePointer<SIMD4<Float>>.allocate(capacity: width)
+                    defer { row.deallocate() }
+
+                    for y in rows {
+                        buffer.loadRow(y, into: row)
+
+                        for x in 0 ..< width {
+                            let pixel = row[x]
+                            guard pixel.w > 0.0 else { continue }
+
+                            let color = SIMD3(pixel.x, pixel.y, pixel.z) / pixel.w
+                            let linearColor = Self.lookup(color, in: decodingTable)
+                            let mappedColor = (matrix * linearColor).clamped(lowerBound: .zero, upperBound: .one)
+                            let encodedColor = Self.lookup(mappedColor, in: encodingTable) * pixel.w
+
+                            row[x] = SIMD4(encodedColor, pixel.w)
+                        }
+
+                        buffer.storeRow(y, from: row)
+                    }
+                }
+            }
+        }
+    }
+
+    @inline(__always)
+    private static func lookup(_ color: SIMD3<Float>, in table: UnsafeBufferPointer<Float>) -> SIMD3<Float> {
+        let position = color.clamped(lowerBound: .zero, upperBound: .one) * Float(lookupTableSize - 1)
+        let lowerIndex = SIMD3<Int32>(position, rounding: .down)
+        let upperIndex = (lowerIndex &+ 1).clamped(lowerBound: .zero,
+                                                   upperBound: SIMD3(repeating: Int32(lookupTableSize - 1)))
+        let fraction = position - SIMD3<Float>(lowerIndex)
+
+        let lower = SIMD3(table[Int(lowerIndex.x)], table[Int(lowerIndex.y)], table[Int(lowerIndex.z)])
+        let upper = SIMD3(table[Int(upperIndex.x)], table[Int(upperIndex.y)], table[Int(upperIndex.z)])
+
+        return lower + (upper - lower) * fraction
+    }
+}
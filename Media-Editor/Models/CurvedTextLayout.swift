@@ -0,0 +1,102 @@
+//
+//  CurvedTextLayout.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 17/07/2024.
+//
+
+#if canImport(Accelerate)
+import Accelerate
+#endif
+import Foundation
+
+struct CurvedTextLayout {
+    struct GlyphPlacement {
+        let center: CGPoint
+        let rotation: CGFloat
+    }
+
+    let radius: CGFloat
+    let size: CGSize
+    let baselineOffset: CGFloat
+    let arcLengths: [CGFloat]
+    let placements: [GlyphPlacement]
+
+    init(advances: [CGFloat], textSize: CGSize, curveDegrees: Double) {
+        let curveRadians = curveDegrees * .pi / 180.0
+        let halfCurveSine = sin(curveRadians * 0.5)
+
+        let curveFactor = abs(curveDegrees) <= 0.5
+            ? 30.0
+            : 0.0267 * tan((abs(curveDegrees) * 0.5 * .pi / 180.0) * 0.5 + .pi * 0.5)
+
+        let radius = ((textSize.height + textSize.width * 6.0) * curveFactor) * copysign(-1.0, curveRadians)
+        let sagitta = 2.0 * abs(radius) * halfCurveSine * halfCurveSine
+        let heightFactor = abs(cos(curveRadians * 0.5 - .pi * 0.5)).squareRoot() * sagitta
+
+        self.radius = radius
+        self.size = CGSize(width: max(textSize.width * abs(cos(curveRadians * 0.5)).squareRoot(),
+                                      sagitta + textSize.height) + textSize.height * 0.25,
+                           height: heightFactor + textSize.height)
+        self.baselineOffset = -radius + heightFactor * 0.5 * copysign(-1.0, -curveRadians)
+
+        let halfArcs = CurvedTextLayout.arcSines(of: advances.map { Double($0 / (2.0 * radius)) })
+        var arcLengths = [CGFloat](repeating: 0.0, count: advances.count + 1)
+        for (index, halfArc) in halfArcs.enumerated() {
+            arcLengths[index + 1] = arcLengths[index] + 2.0 * halfArc
+        }
+        self.arcLengths = arcLengths
+
+        let startAngle = .pi * 0.5 + arcLengths[advances.count] * 0.5
+        let angles = (0 ..< advances.count).map { index in
+            Double(startAngle - (arcLengths[index] + arcLengths[index + 1]) * 0.5)
+        }
+        let (sines, cosines) = CurvedTextLayout.sinesAndCosines(of: angles)
+        self.placements = angles.indices.map { index in
+            GlyphPlacement(center: CGPoint(x: radius * cosines[index], y: -radius * sines[index]),
+                           rotation: .pi * 0.5 - angles[index])
+        }
+    }
+}
+
+// Trigonometry runs over whole arrays at once, falling back to scalar loops where vForce is unavailable.
+private extension CurvedTextLayout {
+    static func arcSines(of values: [Double]) -> [Double] {
+        #if canImport(Accelerate)
+        return vForce.asin(values)
+        #else
+        return values.map { asin($0) }
+        #endif
+    }
+
+    static func sinesAndCosines(of angles: [Double]) -> (sines: [Double], cosines: [Double]) {
+        #if canImport(Accelerate)
+        var sines = [Double](repeating: 0.0, count: angles.count)
+        var cosines = [Double](repeating: 0.0, count: angles.count)
+        vForce.sincos(angles, sinResult: &sines, cosResult: &cosines)
+        return (sines, cosines)
+        #else
+        return (angles.map { sin($0) }, angles.map { cos($0) })
+        #endif
+    }
+}
+
+#if DEBUG
+extension CurvedTextLayout {
+    static func runBenchmark(glyphCounts: [Int] = [16, 256, 4096],
+                             curveDegrees: [Double] = Array(stride(from: -360.0, through: 360.0, by: 15.0)))
+    {
+        for glyphCount in glyphCounts {
+            let advances = (0 ..< glyphCount).map { CGFloat(8 + $0 % 12) }
+            let textSize = CGSize(width: advances.reduce(0.0, +), height: 40.0)
+
+            print("CurvedTextLayout", glyphCount, "glyphs,", curveDegrees.count, "curve angles")
+            MeasureUtilities.functionTime {
+                for curve in curveDegrees {
+                    _ = CurvedTextLayout(advances: advances, textSize: textSize, curveDegrees: curve)
+                }
+            }
+        }
+    }
+}
+#endif
@@ -0,0 +1,46 @@
+//
+//  DisplacementField.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 08/07/2024.
+//
+
+import CoreGraphics
+import Foundation
+
+final class DisplacementField {
+    let width: Int
+    let height: Int
+    let tapCount: Int
+    let origins: UnsafeMutablePointer<SIMD2<Float>>
+    let steps: UnsafeMutablePointer<SIMD2<Float>>?
+    let texture: CGImage?
+
+    init(width: Int, height: Int, tapCount: Int = 1, texture: CGImage? = nil) {
+        self.width = width
+        self.height = height
+        self.tapCount = max(tapCount, 1)
+        self.texture = texture
+
+        let pixelCount = width * height
+        self.origins = UnsafeMutablePointer<SIMD2<Float>>.allocate(capacity: pixelCount)
+        self.origins.initialize(repeating: .zero, count: pixelCount)
+
+        if self.tapCount > 1 {
+            self.steps = UnsafeMutablePointer<SIMD2<Float>>.allocate(capacity: pixelCount)
+            self.steps?.initialize(repeating: .zero, count: pixelCount)
+        } else {
+            self.steps = nil
+        }
+    }
+
+    deinit {
+        origins.deallocate()
+        steps?.deallocate()
+    }
+
+    var byteCost: Int {
+        let pixelCost = MemoryLayout<SIMD2<Float>>.stride * (steps == nil ? 1 : 2)
+        return width * height * pixelCost
+    }
+}
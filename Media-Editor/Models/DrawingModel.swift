@@ -11,13 +11,14 @@ struct DrawingModel {
     var currentPencilType: PencilType = .pencil
     var currentPencilSize: Int = 16
     var currentPencilStyle = ShapeStyleModel(shapeStyle: Color.black, shapeStyleCG: UIColor(Color.black).cgColor)
-    var particlesPositions: [CGPoint] = []
+    var stroke = StrokePointStream()
+
+    var isSmoothed: Bool {
+        return currentPencilType != .pen
+    }
 
     func setupPath(_ path: inout Path) {
-        particlesPositions.forEach { position in
-            path.addLine(to: .init(x: position.x, y: position.y))
-            path.move(to: .init(x: position.x, y: position.y))
-        }
+        stroke.setupPath(&path, isSmoothed: isSmoothed)
     }
 }
 
@@ -26,6 +27,6 @@ extension DrawingModel: Hashable, Equatable {
         hasher.combine(currentPencilType)
         hasher.combine(currentPencilSize)
         hasher.combine(currentPencilStyle)
-        hasher.combine(particlesPositions)
+        hasher.combine(stroke)
     }
 }
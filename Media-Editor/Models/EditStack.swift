@@ -0,0 +1,144 @@
+//
+//  EditStack.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 24/07/2024.
+//
+
+import Foundation
+
+enum EditOperation: Equatable {
+    case filter(FilterType)
+    // Pixel edits without a parametric form (crops, magic wand masks, drawings, backgrounds)
+    // are recorded as the rasterized result stored next to the layer file.
+    case checkpoint(fileName: String)
+}
+
+extension EditOperation {
+    var signature: String {
+        switch self {
+        case .filter(let filter):
+            if let parameterValue = filter.parameterValue {
+                "\(filter.id):\(parameterValue)"
+            } else {
+                filter.id
+            }
+        case .checkpoint(let fileName):
+            fileName
+        }
+    }
+}
+
+extension EditOperation: Codable {
+    private enum CodingKeys: String, CodingKey {
+        case filterID
+        case filterValue
+        case checkpointFileName
+    }
+
+    init(from decoder: Decoder) throws {
+        let container = try decoder.container(keyedBy: CodingKeys.self)
+
+        if let fileName = try container.decodeIfPresent(String.self, forKey: .checkpointFileName) {
+            self = .checkpoint(fileName: fileName)
+            return
+        }
+
+        let filterID = try container.decode(String.self, forKey: .filterID)
+        guard var filter = FilterType.allCases.first(where: { $0.id == filterID }) else {
+            throw DecodingError.dataCorruptedError(forKey: .filterID,
+                                                   in: container,
+                                                   debugDescription: "Unknown filter \(filterID)")
+        }
+
+        if let filterValue = try container.decodeIfPresent(CGFloat.self, forKey: .filterValue) {
+            filter.changeValue(value: filterValue)
+        }
+        self = .filter(filter)
+    }
+
+    func encode(to encoder: Encoder) throws {
+        var container = encoder.container(keyedBy: CodingKeys.self)
+
+        switch self {
+        case .filter(let filter):
+            try container.encode(filter.id, forKey: .filterID)
+            try container.encodeIfPresent(filter.parameterValue, forKey: .filterValue)
+        case .checkpoint(let fileName):
+            try container.encode(fileName, forKey: .checkpointFileName)
+        }
+    }
+}
+
+// Operations past `position` are the redo tail, so undo and redo only move the pointer.
+struct EditStack: Codable, Equatable {
+    static let formatVersion = 1
+
+    private(set) var version = EditStack.formatVersion
+    private(set) var operations = [EditOperation]()
+    private(set) var position = 0
+
+    var appliedOperations: ArraySlice<EditOperation> {
+        return operations.prefix(position)
+    }
+
+    var isEmpty: Bool {
+        return position == 0
+    }
+
+    // The last rasterized state replay starts from, nil meaning the layer's own file.
+    var lastCheckpoint: (index: Int, fileName: String)? {
+        for index in appliedOperations.indices.reversed() {
+            if case .checkpoint(let fileName) = operations[index] {
+                return (index, fileName)
+            }
+        }
+        return nil
+    }
+
+    var pendingFilters: [FilterType] {
+        let startIndex = (lastCheckpoint?.index ?? -1) + 1
+        return appliedOperations.dropFirst(startIndex).compactMap { operation in
+            guard case .filter(let filter) = operation else { return nil }
+            return filter
+        }
+    }
+
+    func signature(upTo position: Int) -> String {
+        return operations.prefix(position).map(\.signature).joined(separator: "|")
+    }
+
+    var checkpointFileNames: [String] {
+        return operations.compactMap { operation in
+            guard case .checkpoint(let fileName) = operation else { return nil }
+            return fileName
+        }
+    }
+
+    // Returns the redo tail dropped by the new operation.
+    @discardableResult
+    mutating func append(_ operation: EditOperation) -> [EditOperation] {
+        let truncatedOperations = Array(operations[position...])
+        operations.removeSubrange(position...)
+        operations.append(operation)
+        position = operations.count
+        return truncatedOperations
+    }
+}
+
+extension EditStack {
+    init(data: Data?) {
+        guard let data,
+              let editStack = try? JSONDecoder().decode(EditStack.self, from: data),
+              editStack.version <= EditStack.formatVersion
+        else {
+            self.init()
+            return
+        }
+        self = editStack
+    }
+
+    var data: Data? {
+        return try? JSONEncoder().encode(self)
+    }
+}
@@ -0,0 +1,56 @@
+//
+//  GradientLookupTable.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 18/07/2024.
+//
+
+import SwiftUI
+
+struct GradientLookupTable {
+    static let entryCount = 1024
+
+    let colors: [SIMD4<Float>]
+
+    init(stops: [Gradient.Stop]) {
+        let resolvedStops = stops
+            .map { (location: Float($0.location), color: Self.components(of: $0.color)) }
+            .sorted { $0.location < $1.location }
+
+        var colors = [SIMD4<Float>](repeating: .zero, count: Self.entryCount)
+
+        if !resolvedStops.isEmpty {
+            var stopIndex = 0
+
+            for entry in 0 ..< Self.entryCount {
+                let location = Float(entry) / Float(Self.entryCount - 1)
+
+                while stopIndex < resolvedStops.count - 1, resolvedStops[stopIndex + 1].location < location {
+                    stopIndex += 1
+                }
+
+                let lowerStop = resolvedStops[stopIndex]
+                let upperStop = resolvedStops[min(stopIndex + 1, resolvedStops.count - 1)]
+
+                let color: SIMD4<Float>
+                if location <= lowerStop.location {
+                    color = lowerStop.color
+                } else if location >= upperStop.location {
+                    color = upperStop.color
+                } else {
+                    let fraction = (location - lowerStop.location) / (upperStop.location - lowerStop.location)
+                    color = lowerStop.color + (upperStop.color - lowerStop.color) * fraction
+                }
+
+                let premultipliedColor = SIMD4(color.x * color.w, color.y * color.w, color.z * color.w, color.w)
+                colors[entry] = premultipliedColor * 255.0
+            }
+        }
+
+        self.colors = colors
+    }
+
+    private static func components(of color: Color) -> SIMD4<Float> {
+        return ColorManagementService.shared.workingComponents(of: UIColor(color).cgColor)
+    }
+}
@@ -21,7 +21,7 @@ struct GradientModel: Equatable {
         didSet {
             if direction != oldValue {
                 gradient = calculateGradient(stops: stops, direction: direction)
-                gradientCG = calculateGradientCG(stops: stops, direction: direction)
+                gradientCG = redirectGradientCG(gradientCG, direction: direction)
             }
         }
     }
@@ -56,7 +56,18 @@ struct GradientModel: Equatable {
         return CGLinearGradient(
             cgGradient: cgGradient,
             startPoint: directionPoints.startPoint,
-            endPoint: directionPoints.endPoint)
+            endPoint: directionPoints.endPoint,
+            lookupTable: GradientLookupTable(stops: deviceRGBStops))
+    }
+
+    // The colors are unchanged, so the CGGradient and its lookup table are carried over.
+    private func redirectGradientCG(_ gradientCG: CGLinearGradient, direction: DirectionType) -> CGLinearGradient {
+        let directionPoints = direction.getStartEndPoints()
+        return CGLinearGradient(
+            cgGradient: gradientCG.cgGradient,
+            startPoint: directionPoints.startPoint,
+            endPoint: directionPoints.endPoint,
+            lookupTable: gradientCG.lookupTable)
     }
 
     static func == (lhs: GradientModel, rhs: GradientModel) -> Bool {
@@ -46,12 +46,17 @@ final class ImageProjectModel: ObservableObject {
         }
     }
 
+    @Published var pixelPrecision: PixelPrecisionType {
+        willSet { imageProjectEntity.pixelPrecision = newValue.rawValue }
+    }
+
     init(imageProjectEntity: ImageProjectEntity) {
         self.imageProjectEntity = imageProjectEntity
         self.id = imageProjectEntity.id
         self.title = imageProjectEntity.title
         self.lastEditDate = imageProjectEntity.lastEditDate
         self.backgroundColor = Color(hex: imageProjectEntity.backgroundColorHex)
+        self.pixelPrecision = PixelPrecisionType(rawValue: imageProjectEntity.pixelPrecision ?? "") ?? .eight
         self.photoEntities = imageProjectEntity
             .imageProjectEntityToPhotoEntity
             ?? Set<PhotoEntity>()
@@ -65,15 +70,15 @@ final class ImageProjectModel: ObservableObject {
 }
 
 extension ImageProjectModel {
+    // All entities of an import land in one relationship update and one save.
     func insertPhotosEntityToProject(fileNames: [String]) throws {
-        for fileName in fileNames {
-            let photoEntity = PhotoEntity(fileName: fileName,
-                                          projectEntity: imageProjectEntity)
+        PersistenceController.shared.performTransaction {
+            let insertedPhotoEntities = fileNames.map { fileName in
+                PhotoEntity(fileName: fileName, projectEntity: imageProjectEntity)
+            }
 
-            insertPhotosToEntity(photo: photoEntity)
+            photoEntities = photoEntities.union(insertedPhotoEntities)
         }
-
-        PersistenceController.shared.saveChanges()
     }
 
     func insertPhotosToEntity(photo: PhotoEntity) {
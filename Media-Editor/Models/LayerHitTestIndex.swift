@@ -0,0 +1,198 @@
+//
+//  LayerHitTestIndex.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 15/07/2024.
+//
+
+import CoreGraphics
+import Foundation
+
+final class LayerHitTestIndex {
+    private struct Geometry: Equatable {
+        let center: CGPoint
+        let size: CGSize
+        let scaleX: Double
+        let scaleY: Double
+        let rotation: Double
+        let positionZ: Int
+    }
+
+    private final class AlphaMask {
+        let width: Int
+        let height: Int
+        let alpha: [UInt8]
+
+        init?(cgImage: CGImage, maxDimension: Int) {
+            let scale = min(1.0, CGFloat(maxDimension) / CGFloat(max(cgImage.width, cgImage.height)))
+            let width = max(1, Int((CGFloat(cgImage.width) * scale).rounded()))
+            let height = max(1, Int((CGFloat(cgImage.height) * scale).rounded()))
+            var alpha = [UInt8](repeating: 0, count: width * height)
+
+            let isDrawn = alpha.withUnsafeMutableBytes { alphaBuffer in
+                guard let context = CGContext(data: alphaBuffer.baseAddress,
+                                              width: width,
+                                              height: height,
+                                              bitsPerComponent: 8,
+                                              bytesPerRow: width,
+                                              space: CGColorSpaceCreateDeviceGray(),
+                                              bitmapInfo: CGImageAlphaInfo.alphaOnly.rawValue)
+                else { return false }
+
+                context.interpolationQuality = .medium
+                context.draw(cgImage, in: CGRect(x: 0, y: 0, width: width, height: height))
+                return true
+            }
+            guard isDrawn else { return nil }
+
+            self.width = width
+            self.height = height
+            self.alpha = alpha
+        }
+
+        func alpha(atUnitX unitX: CGFloat, unitY: CGFloat) -> UInt8 {
+            let x = min(max(Int(unitX * CGFloat(width)), 0), width - 1)
+            let y = min(max(Int(unitY * CGFloat(height)), 0), height - 1)
+            return alpha[y * width + x]
+        }
+    }
+
+    private struct Entry {
+        let layer: LayerModel
+        let geometry: Geometry
+        let cells: [SIMD2<Int>]
+        var alphaMaskSource: CGImage?
+        var alphaMask: AlphaMask?
+    }
+
+    private let cellSize: CGFloat
+    private let alphaMaskMaxDimension: Int
+    private var entries: [String: Entry] = [:]
+    private var grid: [SIMD2<Int>: Set<String>] = [:]
+
+    init(cellSize: CGFloat = 128.0, alphaMaskMaxDimension: Int = 256) {
+        self.cellSize = cellSize
+        self.alphaMaskMaxDimension = alphaMaskMaxDimension
+    }
+
+    func sync(with layers: [LayerModel]) {
+        var visibleLayerIds = Set<String>()
+
+        for layer in layers where (layer.positionZ ?? 0) > 0 {
+            guard let geometry = geometry(of: layer) else { continue }
+            visibleLayerIds.insert(layer.id)
+
+            if let entry = entries[layer.id], entry.geometry == geometry, entry.layer === layer { continue }
+            remove(layerId: layer.id)
+            insert(layer: layer, geometry: geometry)
+        }
+
+        for layerId in entries.keys where !visibleLayerIds.contains(layerId) {
+            remove(layerId: layerId)
+        }
+    }
+
+    func topmostLayer(at point: CGPoint, alphaThreshold: UInt8? = nil) -> LayerModel? {
+        let cell = SIMD2(Int((point.x / cellSize).rounded(.down)), Int((point.y / cellSize).rounded(.down)))
+        guard let candidateIds = grid[cell] else { return nil }
+
+        let candidates = candidateIds
+            .compactMap { entries[$0] }
+            .sorted { $0.geometry.positionZ > $1.geometry.positionZ }
+
+        for candidate in candidates {
+            guard let unitPosition = unitPosition(of: point, in: candidate.geometry) else { continue }
+            guard let alphaThreshold else { return candidate.layer }
+
+            if alphaMask(for: candidate.layer.id)?.alpha(atUnitX: unitPosition.x, unitY: unitPosition.y)
+                ?? UInt8.max >= alphaThreshold
+            {
+                return candidate.layer
+            }
+        }
+        return nil
+    }
+
+    func removeAll() {
+        entries.removeAll()
+        grid.removeAll()
+    }
+
+    private func geometry(of layer: LayerModel) -> Geometry? {
+        guard let position = layer.position,
+              let size = layer.size,
+              let scaleX = layer.scaleX,
+              let scaleY = layer.scaleY,
+              let rotation = layer.rotation,
+              let positionZ = layer.positionZ
+        else { return nil }
+
+        return Geometry(center: position, size: size, scaleX: scaleX, scaleY: scaleY,
+                        rotation: rotation.radians, positionZ: positionZ)
+    }
+
+    private func insert(layer: LayerModel, geometry: Geometry) {
+        let halfWidth = geometry.size.width * abs(geometry.scaleX) * 0.5
+        let halfHeight = geometry.size.height * abs(geometry.scaleY) * 0.5
+        let cosine = abs(cos(geometry.rotation))
+        let sine = abs(sin(geometry.rotation))
+        let extentX = cosine * halfWidth + sine * halfHeight
+        let extentY = sine * halfWidth + cosine * halfHeight
+
+        let minCellX = Int(((geometry.center.x - extentX) / cellSize).rounded(.down))
+        let maxCellX = Int(((geometry.center.x + extentX) / cellSize).rounded(.down))
+        let minCellY = Int(((geometry.center.y - extentY) / cellSize).rounded(.down))
+        let maxCellY = Int(((geometry.center.y + extentY) / cellSize).rounded(.down))
+
+        var cells: [SIMD2<Int>] = []
+        for cellY in minCellY ... maxCellY {
+            for cellX in minCellX ... maxCellX {
+                let cell = SIMD2(cellX, cellY)
+                grid[cell, default: []].insert(layer.id)
+                cells.append(cell)
+            }
+        }
+
+        let previousEntry = entries[layer.id]
+        entries[layer.id] = Entry(layer: layer,
+                                  geometry: geometry,
+                                  cells: cells,
+                                  alphaMaskSource: previousEntry?.alphaMaskSource,
+                                  alphaMask: previousEntry?.alphaMask)
+    }
+
+    private func remove(layerId: String) {
+        guard let entry = entries[layerId] else { return }
+
+        for cell in entry.cells {
+            grid[cell]?.remove(layerId)
+            if grid[cell]?.isEmpty == true {
+                grid[cell] = nil
+            }
+        }
+        entries[layerId] = nil
+    }
+
+    private func unitPosition(of point: CGPoint, in geometry: Geometry) -> CGPoint? {
+        let deltaX = point.x - geometry.center.x
+        let deltaY = point.y - geometry.center.y
+        let cosine = cos(geometry.rotation)
+        let sine = sin(geometry.rotation)
+
+        let localX = (cosine * deltaX + sine * deltaY) / (geometry.size.width * geometry.scaleX)
+        let localY = (-sine * deltaX + cosine * deltaY) / (geometry.size.height * geometry.scaleY)
+
+        guard abs(localX) <= 0.5, abs(localY) <= 0.5 else { return nil }
+        return CGPoint(x: localX + 0.5, y: localY + 0.5)
+    }
+
+    private func alphaMask(for layerId: String) -> AlphaMask? {
+        guard var entry = entries[layerId], let cgImage = entry.layer.cgImage else { return nil }
+        if entry.alphaMaskSource === cgImage { return entry.alphaMask }
+
+        entry.alphaMask = AlphaMask(cgImage: cgImage, maxDimension: alphaMaskMaxDimension)
+        entry.alphaMaskSource = cgImage
+        entries[layerId] = entry
+        return entry.alphaMask
+    }
+}
@@ -13,6 +13,7 @@ class LayerModel: Identifiable, ObservableObject, NSCopying {
     var id: String { fileName }
     let fileName: String
     var cgImage: CGImage?
+    private(set) var sourceColorSpaceName: String?
 
     let photoEntity: PhotoEntity
 
@@ -29,32 +30,69 @@ class LayerModel: Identifiable, ObservableObject, NSCopying {
 
     @Published var rotation: Angle? {
         willSet { photoEntity.rotation = newValue!.radians as NSNumber }
+        didSet { cachedWorldExtent = nil }
     }
 
     @Published var scaleX: Double? {
         willSet { photoEntity.scaleX = newValue! as NSNumber }
+        didSet { cachedWorldExtent = nil }
     }
 
     @Published var scaleY: Double? {
         willSet { photoEntity.scaleY = newValue! as NSNumber }
+        didSet { cachedWorldExtent = nil }
     }
 
     @Published var toDelete: Bool? {
         willSet { photoEntity.toDelete = newValue! }
     }
 
-    @Published var size: CGSize?
+    @Published var blendMode: BlendModeType {
+        willSet { photoEntity.blendMode = newValue.rawValue }
+    }
+
+    @Published var opacity: Double {
+        willSet { photoEntity.opacity = newValue }
+    }
+
+    var editStack: EditStack {
+        willSet { photoEntity.editStack = newValue.data }
+    }
+
+    // The image matching the stack's current position; anything else in `cgImage` is uncommitted.
+    var committedCGImage: CGImage?
+
+    @Published var size: CGSize? {
+        didSet { cachedWorldExtent = nil }
+    }
+
+    private var cachedWorldExtent: CGSize?
+    private var importProxy: CGImage?
+
+    private var isSnapshot = false
+    private var snapshotImageLease: ImageCacheService.Lease?
+    private var snapshotCommittedImageLease: ImageCacheService.Lease?
 
-    init(photoEntity: PhotoEntity) {
+    init(photoEntity: PhotoEntity, cgImage: CGImage? = nil, isLoadingImage: Bool = true) {
         self.photoEntity = photoEntity
         self.fileName = photoEntity.fileName!
 
         self.positionZ = photoEntity.positionZ?.intValue
-        do {
-            self.cgImage = try createCGImage(absoluteFilePath: absoluteFilePath)
-        } catch {
-            print(error)
-            self.cgImage = nil
+        self.blendMode = BlendModeType(rawValue: photoEntity.blendMode ?? "") ?? .normal
+        self.opacity = photoEntity.opacity
+        self.editStack = EditStack(data: photoEntity.editStack)
+        if let cgImage {
+            self.cgImage = managedCGImage(cgImage)
+        } else if isLoadingImage {
+            self.cgImage = checkpointCGImage(of: editStack)
+        }
+
+        if editStack.pendingFilters.isEmpty {
+            self.committedCGImage = self.cgImage
+        }
+
+        if isLoadingImage, editStack.isEmpty, isOriginalFileCurrent() {
+            self.importProxy = self.cgImage
         }
 
         self.position = CGPoint(x: photoEntity.positionX!.doubleValue, y: photoEntity.positionY!.doubleValue as Double)
@@ -66,19 +104,78 @@ class LayerModel: Identifiable, ObservableObject, NSCopying {
         self.toDelete = photoEntity.toDelete
     }
 
+    deinit {
+        for lease in [snapshotImageLease, snapshotCommittedImageLease].compactMap({ $0 }) {
+            ImageCacheService.shared.release(lease)
+        }
+    }
+
     func copy(with zone: NSZone? = nil) -> Any {
         return LayerModel(photoEntity: photoEntity)
     }
 
+    func copyWithoutImage() -> LayerModel {
+        return LayerModel(photoEntity: photoEntity, isLoadingImage: false)
+    }
+
     func copy(withCGImage: Bool, with zone: NSZone? = nil) -> Any {
         let layerModel = copy(with: zone) as! LayerModel
 
         if withCGImage {
             layerModel.cgImage = cgImage
+            layerModel.committedCGImage = committedCGImage
         }
 
         return layerModel
     }
+
+    // Snapshots lease their bitmaps from the image cache instead of pinning them for the whole
+    // undo history; an evicted bitmap is rebuilt from the edit stack on restore.
+    func snapshotCopy(withCGImage: Bool) -> LayerModel {
+        let layerModel = copyWithoutImage()
+        layerModel.isSnapshot = true
+
+        guard withCGImage else { return layerModel }
+
+        let imageCache = ImageCacheService.shared
+        layerModel.snapshotImageLease = cgImage.map {
+            imageCache.retainImage($0, forKey: snapshotImageKey(of: $0), in: .snapshot)
+        }
+        layerModel.snapshotCommittedImageLease = committedCGImage.map {
+            imageCache.retainImage($0, forKey: snapshotImageKey(of: $0), in: .snapshot)
+        }
+        return layerModel
+    }
+
+    // Returns false when the snapshot's bitmap is gone and the caller has to regenerate it.
+    func loadSnapshotImages(from snapshotLayer: LayerModel) -> Bool {
+        // Drawing and cropping snapshots share the live layers, which keep their bitmaps.
+        guard snapshotLayer.isSnapshot else {
+            cgImage = snapshotLayer.cgImage
+            committedCGImage = snapshotLayer.committedCGImage
+            return true
+        }
+
+        let imageCache = ImageCacheService.shared
+        let snapshotCGImage = snapshotLayer.snapshotImageLease.flatMap { imageCache.image(for: $0) }
+
+        if let snapshotCGImage {
+            cgImage = snapshotCGImage
+            committedCGImage = snapshotLayer.snapshotCommittedImageLease.flatMap { imageCache.image(for: $0) }
+        } else {
+            cgImage = checkpointCGImage(of: snapshotLayer.editStack)
+            committedCGImage = nil
+        }
+
+        if snapshotLayer === self {
+            isSnapshot = false
+        }
+        return snapshotCGImage != nil
+    }
+
+    private func snapshotImageKey(of cgImage: CGImage) -> String {
+        return "\(fileName)#\(ObjectIdentifier(cgImage).hashValue)"
+    }
 }
 
 extension LayerModel {
@@ -99,6 +196,84 @@ extension LayerModel {
         return CGSize(width: cgImage.width, height: cgImage.height)
     }
 
+    var worldBounds: CGRect? {
+        guard let position, let extent = worldExtent else { return nil }
+
+        return CGRect(x: position.x - extent.width,
+                      y: position.y - extent.height,
+                      width: extent.width * 2.0,
+                      height: extent.height * 2.0)
+    }
+
+    private var worldExtent: CGSize? {
+        if let cachedWorldExtent { return cachedWorldExtent }
+        guard let size, let rotation, let scaleX, let scaleY else { return nil }
+
+        let halfWidth = size.width * abs(scaleX) * 0.5
+        let halfHeight = size.height * abs(scaleY) * 0.5
+        let cosine = abs(cos(rotation.radians))
+        let sine = abs(sin(rotation.radians))
+
+        let extent = CGSize(width: cosine * halfWidth + sine * halfHeight,
+                            height: sine * halfWidth + cosine * halfHeight)
+        cachedWorldExtent = extent
+        return extent
+    }
+
+    var isShowingImportProxy: Bool {
+        return importProxy != nil && cgImage === importProxy
+    }
+
+    func originalCGImage() -> CGImage? {
+        guard isShowingImportProxy else { return cgImage }
+        return (try? createCGImage(absoluteFilePath: photoEntity.absoluteOriginalFilePath)) ?? cgImage
+    }
+
+    // Called once a checkpoint supersedes the imported pixels; building a layer never touches the disk.
+    func removeOriginalFile() {
+        importProxy = nil
+        try? FileManager.default.removeItem(atPath: photoEntity.absoluteOriginalFilePath)
+    }
+
+    // Maintenance for layers loaded from disk: a checkpoint or a rewritten working copy supersedes the original.
+    func removeObsoleteOriginalFile() {
+        guard !editStack.checkpointFileNames.isEmpty || !isOriginalFileCurrent() else { return }
+        removeOriginalFile()
+    }
+
+    // The original stays valid only until the working copy is rewritten by an edit.
+    private func isOriginalFileCurrent() -> Bool {
+        let fileManager = FileManager.default
+        let originalFilePath = photoEntity.absoluteOriginalFilePath
+
+        guard let originalDate = (try? fileManager.attributesOfItem(atPath: originalFilePath))?[.modificationDate]
+            as? Date
+        else { return false }
+
+        guard let workingDate = (try? fileManager.attributesOfItem(atPath: absoluteFilePath))?[.modificationDate]
+            as? Date,
+            workingDate <= originalDate
+        else { return false }
+
+        return true
+    }
+
+    // Filters after the checkpoint are replayed by the render graph, not stored as pixels.
+    func checkpointCGImage(of editStack: EditStack) -> CGImage? {
+        let filePath = if let checkpoint = editStack.lastCheckpoint {
+            photoEntity.absoluteCheckpointFilePath(fileName: checkpoint.fileName)
+        } else {
+            absoluteFilePath
+        }
+
+        do {
+            return try createCGImage(absoluteFilePath: filePath)
+        } catch {
+            print(error)
+            return nil
+        }
+    }
+
     var pixelToDigitalWidthRatio: CGFloat {
         guard let size else { return .zero }
         return pixelSize.width / size.width
@@ -124,7 +299,19 @@ extension LayerModel {
             throw CGImageError.imageFromSourceCreation
         }
 
-        return cgImage
+        return managedCGImage(cgImage)
+    }
+
+    // Layers are converted into the working space once on load, so renders never re-match them.
+    private func managedCGImage(_ cgImage: CGImage) -> CGImage {
+        sourceColorSpaceName = cgImage.colorSpace?.name as String?
+
+        do {
+            return try ColorManagementService.shared.convertToWorkingColorSpace(cgImage)
+        } catch {
+            print(error)
+            return cgImage
+        }
     }
 
     func topLeftApexPosition(position newPosition: CGPoint? = nil) -> CGPoint {
@@ -0,0 +1,86 @@
+//
+//  LayerSnappingIndex.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 14/07/2024.
+//
+
+import Foundation
+
+struct LayerSnappingIndex {
+    let excludedLayerId: String
+
+    private let edgesX: [CGFloat]
+    private let edgesY: [CGFloat]
+    private let centersX: [CGFloat]
+    private let centersY: [CGFloat]
+
+    init(layers: [LayerModel], excluding excludedLayer: LayerModel) {
+        var edgesX: [CGFloat] = []
+        var edgesY: [CGFloat] = []
+        var centersX: [CGFloat] = []
+        var centersY: [CGFloat] = []
+
+        for layer in layers where (layer.positionZ ?? 0) > 0 && layer != excludedLayer {
+            guard let position = layer.position,
+                  let rotation = layer.rotation,
+                  layer.size != nil,
+                  layer.scaleX != nil,
+                  layer.scaleY != nil
+            else { continue }
+
+            centersX.append(position.x)
+            centersY.append(position.y)
+
+            guard rotation.isRightAngle else { continue }
+
+            edgesX.append(layer.rotatedApexPositionFunction(apex: .bottomLeft)(nil).x)
+            edgesX.append(layer.rotatedApexPositionFunction(apex: .topRight)(nil).x)
+            edgesY.append(layer.rotatedApexPositionFunction(apex: .topLeft)(nil).y)
+            edgesY.append(layer.rotatedApexPositionFunction(apex: .bottomRight)(nil).y)
+        }
+
+        self.excludedLayerId = excludedLayer.id
+        self.edgesX = edgesX.sorted()
+        self.edgesY = edgesY.sorted()
+        self.centersX = centersX.sorted()
+        self.centersY = centersY.sorted()
+    }
+
+    func nearestEdgeX(to value: CGFloat, tolerance: CGFloat) -> CGFloat? {
+        return nearest(to: value, in: edgesX, tolerance: tolerance)
+    }
+
+    func nearestEdgeY(to value: CGFloat, tolerance: CGFloat) -> CGFloat? {
+        return nearest(to: value, in: edgesY, tolerance: tolerance)
+    }
+
+    func nearestCenterX(to value: CGFloat, tolerance: CGFloat) -> CGFloat? {
+        return nearest(to: value, in: centersX, tolerance: tolerance)
+    }
+
+    func nearestCenterY(to value: CGFloat, tolerance: CGFloat) -> CGFloat? {
+        return nearest(to: value, in: centersY, tolerance: tolerance)
+    }
+
+    private func nearest(to value: CGFloat, in coordinates: [CGFloat], tolerance: CGFloat) -> CGFloat? {
+        var lowerBound = 0
+        var upperBound = coordinates.count
+
+        while lowerBound < upperBound {
+            let middle = (lowerBound + upperBound) / 2
+            if coordinates[middle] < value {
+                lowerBound = middle + 1
+            } else {
+                upperBound = middle
+            }
+        }
+
+        let candidates = [lowerBound - 1, lowerBound]
+            .filter { coordinates.indices.contains($0) }
+            .map { coordinates[$0] }
+            .filter { abs($0 - value) < tolerance }
+
+        return candidates.min { abs($0 - value) < abs($1 - value) }
+    }
+}
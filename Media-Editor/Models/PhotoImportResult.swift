@@ -0,0 +1,44 @@
+//
+//  PhotoImportResult.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 21/07/2024.
+//
+
+import CoreGraphics
+import Foundation
+
+struct PhotoImportOptions {
+    enum ProxySize {
+        case none
+        case original
+        case maxPixelSize(Int)
+    }
+
+    var maxConcurrentImports: Int = 3
+    var chunkCapacity: Int = 1 << 20
+    var proxySize: ProxySize = .none
+    var workingMaxPixelSize: Int?
+    var thumbnailMaxPixelSize: Int = 256
+}
+
+struct PhotoImportMetrics {
+    var byteCount: Int = 0
+    var transferDuration: TimeInterval = 0.0
+    var decodeDuration: TimeInterval = 0.0
+
+    var totalDuration: TimeInterval { transferDuration + decodeDuration }
+
+    static func + (lhs: PhotoImportMetrics, rhs: PhotoImportMetrics) -> PhotoImportMetrics {
+        return PhotoImportMetrics(byteCount: lhs.byteCount + rhs.byteCount,
+                                  transferDuration: lhs.transferDuration + rhs.transferDuration,
+                                  decodeDuration: lhs.decodeDuration + rhs.decodeDuration)
+    }
+}
+
+struct PhotoImportResult {
+    let fileName: String
+    let proxy: CGImage?
+    let thumbnail: CGImage?
+    let metrics: PhotoImportMetrics
+}
@@ -0,0 +1,174 @@
+//
+//  PixelBuffer.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 08/07/2024.
+//
+
+import CoreGraphics
+import Foundation
+
+final class PixelBuffer {
+    let width: Int
+    let height: Int
+    let precision: PixelPrecisionType
+    let colorSpace: CGColorSpace
+    let bytesPerRow: Int
+    let data: UnsafeMutablePointer<UInt8>
+
+    init(width: Int,
+         height: Int,
+         precision: PixelPrecisionType = .eight,
+         colorSpace: CGColorSpace = ColorManagementService.shared.workingColorSpace)
+    {
+        self.width = width
+        self.height = height
+        self.precision = precision
+        self.colorSpace = colorSpace
+        self.bytesPerRow = width * precision.bytesPerPixel
+        self.data = UnsafeMutablePointer<UInt8>.allocate(capacity: bytesPerRow * height)
+        self.data.initialize(repeating: 0, count: bytesPerRow * height)
+    }
+
+    convenience init(cgImage: CGImage,
+                     precision: PixelPrecisionType = .eight,
+                     colorSpace: CGColorSpace = ColorManagementService.shared.workingColorSpace) throws
+    {
+        self.init(width: cgImage.width, height: cgImage.height, precision: precision, colorSpace: colorSpace)
+
+        let context = try createContext()
+        context.draw(cgImage, in: CGRect(x: 0, y: 0, width: width, height: height))
+    }
+
+    deinit {
+        data.deallocate()
+    }
+
+    var size: CGSize {
+        return CGSize(width: width, height: height)
+    }
+
+    func createContext(colorSpace: CGColorSpace? = nil) throws -> CGContext {
+        guard let context = precision.createContext(width: width,
+                                                    height: height,
+                                                    data: data,
+                                                    colorSpace: colorSpace ?? self.colorSpace)
+        else {
+            throw PhotoExportError.contextCreation(contextSize: size)
+        }
+        return context
+    }
+
+    // Passing a color space re-tags the pixels without converting them.
+    func makeCGImage(colorSpace: CGColorSpace? = nil) throws -> CGImage {
+        guard let cgImage = try createContext(colorSpace: colorSpace).makeImage() else {
+            throw PhotoExportError.contextImageMaking
+        }
+        return cgImage
+    }
+}
+
+// Kernels read and write every precision in the 0...255 range of the 8-bit buffers,
+// so filters only ever see one value scale.
+extension PixelBuffer {
+    @inline(__always)
+    func pixel(x: Int, y: Int) -> SIMD4<Float> {
+        let pixelPointer = UnsafeRawPointer(data + y * bytesPerRow + x * precision.bytesPerPixel)
+
+        switch precision {
+        case .eight:
+            return SIMD4<Float>(pixelPointer.loadUnaligned(as: SIMD4<UInt8>.self))
+        case .sixteen:
+            return SIMD4<Float>(pixelPointer.loadUnaligned(as: SIMD4<UInt16>.self)) * (255.0 / 65535.0)
+        case .halfFloat:
+            return SIMD4<Float>(pixelPointer.loadUnaligned(as: SIMD4<Float16>.self)) * 255.0
+        }
+    }
+
+    @inline(__always)
+    func setPixel(x: Int, y: Int, _ value: SIMD4<Float>) {
+        let pixelPointer = UnsafeMutableRawPointer(data + y * bytesPerRow + x * precision.bytesPerPixel)
+        let clampedValue = value.clamped(lowerBound: .zero, upperBound: SIMD4(repeating: 255.0))
+
+        switch precision {
+        case .eight:
+            pixelPointer.storeBytes(of: SIMD4<UInt8>(clampedValue + 0.5), as: SIMD4<UInt8>.self)
+        case .sixteen:
+            pixelPointer.storeBytes(of: SIMD4<UInt16>(clampedValue * (65535.0 / 255.0) + 0.5),
+                                    as: SIMD4<UInt16>.self)
+        case .halfFloat:
+            pixelPointer.storeBytes(of: SIMD4<Float16>(clampedValue * (1.0 / 255.0)), as: SIMD4<Float16>.self)
+        }
+    }
+
+    func loadRow(_ y: Int, into row: UnsafeMutablePointer<SIMD4<Float>>) {
+        let rowPointer = UnsafeRawPointer(data + y * bytesPerRow)
+
+        switch precision {
+        case .eight:
+            let pixels = rowPointer.assumingMemoryBound(to: SIMD4<UInt8>.self)
+            for x in 0 ..< width {
+                row[x] = SIMD4<Float>(pixels[x])
+            }
+        case .sixteen:
+            let pixels = rowPointer.assumingMemoryBound(to: SIMD4<UInt16>.self)
+            for x in 0 ..< width {
+                row[x] = SIMD4<Float>(pixels[x]) * (255.0 / 65535.0)
+            }
+        case .halfFloat:
+            let pixels = rowPointer.assumingMemoryBound(to: SIMD4<Float16>.self)
+            for x in 0 ..< width {
+                row[x] = SIMD4<Float>(pixels[x]) * 255.0
+            }
+        }
+    }
+
+    func storeRow(_ y: Int, from row: UnsafePointer<SIMD4<Float>>) {
+        let rowPointer = UnsafeMutableRawPointer(data + y * bytesPerRow)
+        let upperBound = SIMD4<Float>(repeating: 255.0)
+
+        switch precision {
+        case .eight:
+            let pixels = rowPointer.assumingMemoryBound(to: SIMD4<UInt8>.self)
+            for x in 0 ..< width {
+                pixels[x] = SIMD4<UInt8>(row[x].clamped(lowerBound: .zero, upperBound: upperBound) + 0.5)
+            }
+        case .sixteen:
+            let pixels = rowPointer.assumingMemoryBound(to: SIMD4<UInt16>.self)
+            for x in 0 ..< width {
+                pixels[x] = SIMD4<UInt16>(row[x].clamped(lowerBound: .zero, upperBound: upperBound)
+                    * (65535.0 / 255.0) + 0.5)
+            }
+        case .halfFloat:
+            let pixels = rowPointer.assumingMemoryBound(to: SIMD4<Float16>.self)
+            for x in 0 ..< width {
+                pixels[x] = SIMD4<Float16>(row[x].clamped(lowerBound: .zero, upperBound: upperBound) * (1.0 / 255.0))
+            }
+        }
+    }
+
+    @inline(__always)
+    func bilinearSample(x: Float, y: Float) -> SIMD4<Float> {
+        let clampedX = min(max(x, 0.0), Float(width - 1))
+        let clampedY = min(max(y, 0.0), Float(height - 1))
+
+        let x0 = Int(clampedX)
+        let y0 = Int(clampedY)
+        let x1 = min(x0 + 1, width - 1)
+        let y1 = min(y0 + 1, height - 1)
+
+        let fractionX = SIMD4<Float>(repeating: clampedX - Float(x0))
+        let fractionY = SIMD4<Float>(repeating: clampedY - Float(y0))
+
+        let top = pixel(x: x0, y: y0) + (pixel(x: x1, y: y0) - pixel(x: x0, y: y0)) * fractionX
+        let bottom = pixel(x: x0, y: y1) + (pixel(x: x1, y: y1) - pixel(x: x0, y: y1)) * fractionX
+
+        return top + (bottom - top) * fractionY
+    }
+
+    @inline(__always)
+    func luminance(x: Int, y: Int) -> Float {
+        let value = pixel(x: min(max(x, 0), width - 1), y: min(max(y, 0), height - 1))
+        return (value.x * 0.299 + value.y * 0.587 + value.z * 0.114) / 255.0
+    }
+}
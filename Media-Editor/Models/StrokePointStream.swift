@@ -0,0 +1,207 @@
+//
+//  StrokePointStream.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 12/07/2024.
+//
+
+import SwiftUI
+
+struct StrokePointStream {
+    static let quantizationScale: CGFloat = 8.0
+    static let simplificationPixelTolerance: CGFloat = 0.75
+
+    private static let hashOffsetBasis: UInt64 = 14_695_981_039_346_656_037
+    private static let hashPrime: UInt64 = 1_099_511_628_211
+    private static let maxPendingSampleCount = 64
+    private static let flatteningStep: CGFloat = 2.0
+    private static let maxFlatteningSubdivisions = 16
+
+    private(set) var committedPoints: [SIMD2<Int16>] = []
+    private(set) var isFinished = false
+    private var tailPoint: SIMD2<Int16>?
+    private var pendingSamples: [SIMD2<Int16>] = []
+    private var committedHash = StrokePointStream.hashOffsetBasis
+
+    static func tolerance(pixelsPerPoint: CGFloat, displayScale: CGFloat) -> CGFloat {
+        guard pixelsPerPoint > 0.0, displayScale > 0.0 else { return 0.0 }
+        return max(simplificationPixelTolerance / pixelsPerPoint, 1.0 / displayScale)
+    }
+
+    var count: Int {
+        return committedPoints.count + (tailPoint == nil ? 0 : 1)
+    }
+
+    var isEmpty: Bool {
+        return count == 0
+    }
+
+    var points: [CGPoint] {
+        var points = committedPoints.map(StrokePointStream.decode)
+        if let tailPoint {
+            points.append(StrokePointStream.decode(tailPoint))
+        }
+        return points
+    }
+
+    func point(at index: Int) -> CGPoint {
+        return index < committedPoints.count
+            ? StrokePointStream.decode(committedPoints[index])
+            : StrokePointStream.decode(tailPoint ?? committedPoints[committedPoints.count - 1])
+    }
+
+    mutating func append(_ position: CGPoint, tolerance: CGFloat) {
+        let point = StrokePointStream.encode(position)
+        isFinished = false
+
+        guard let previousTailPoint = tailPoint, let anchorPoint = committedPoints.last else {
+            if committedPoints.isEmpty {
+                commit(point)
+            } else {
+                tailPoint = point
+                pendingSamples = [point]
+            }
+            return
+        }
+
+        guard tolerance > 0.0, pendingSamples.count < StrokePointStream.maxPendingSampleCount else {
+            commit(previousTailPoint)
+            tailPoint = point
+            pendingSamples = [point]
+            return
+        }
+
+        let anchor = StrokePointStream.decode(anchorPoint)
+        let candidate = StrokePointStream.decode(point)
+        let isWithinTolerance = pendingSamples.allSatisfy { sample in
+            StrokePointStream.distance(of: StrokePointStream.decode(sample), toSegmentFrom: anchor, to: candidate)
+                <= tolerance
+        }
+
+        if isWithinTolerance {
+            tailPoint = point
+            pendingSamples.append(point)
+        } else {
+            commit(previousTailPoint)
+            tailPoint = point
+            pendingSamples = [point]
+        }
+    }
+
+    mutating func finish() {
+        if let tailPoint {
+            commit(tailPoint)
+        }
+        tailPoint = nil
+        pendingSamples.removeAll()
+        isFinished = true
+    }
+
+    mutating func removeAll() {
+        self = StrokePointStream()
+    }
+
+    func stableSegmentCount(isSmoothed: Bool) -> Int {
+        guard !isFinished else { return committedPoints.count }
+        return isSmoothed ? max(committedPoints.count - 1, 0) : committedPoints.count
+    }
+
+    func flattenedSegment(_ index: Int, isSmoothed: Bool) -> [CGPoint] {
+        let end = point(at: index)
+        guard index > 0, isSmoothed else { return [end] }
+
+        let (start, controlPoint1, controlPoint2) = curveControlPoints(toSegment: index)
+        let chordLength = hypot(end.x - start.x, end.y - start.y)
+        let subdivisions = min(max(Int((chordLength / StrokePointStream.flatteningStep).rounded(.up)), 1),
+                               StrokePointStream.maxFlatteningSubdivisions)
+
+        return (1 ... subdivisions).map { step in
+            let t = CGFloat(step) / CGFloat(subdivisions)
+            let inverseT = 1.0 - t
+            let startWeight = inverseT * inverseT * inverseT
+            let controlPoint1Weight = 3.0 * inverseT * inverseT * t
+            let controlPoint2Weight = 3.0 * inverseT * t * t
+            let endWeight = t * t * t
+
+            return CGPoint(x: start.x * startWeight + controlPoint1.x * controlPoint1Weight
+                               + controlPoint2.x * controlPoint2Weight + end.x * endWeight,
+                           y: start.y * startWeight + controlPoint1.y * controlPoint1Weight
+                               + controlPoint2.y * controlPoint2Weight + end.y * endWeight)
+        }
+    }
+
+    func setupPath(_ path: inout Path, isSmoothed: Bool) {
+        guard !isEmpty else { return }
+
+        let firstPosition = point(at: 0)
+        path.move(to: firstPosition)
+
+        guard count > 1 else {
+            path.addLine(to: firstPosition)
+            return
+        }
+
+        for index in 1 ..< count {
+            if isSmoothed {
+                let (_, controlPoint1, controlPoint2) = curveControlPoints(toSegment: index)
+                path.addCurve(to: point(at: index), control1: controlPoint1, control2: controlPoint2)
+            } else {
+                path.addLine(to: point(at: index))
+            }
+        }
+    }
+
+    private func curveControlPoints(toSegment index: Int) -> (CGPoint, CGPoint, CGPoint) {
+        let previous = point(at: max(index - 2, 0))
+        let start = point(at: index - 1)
+        let end = point(at: index)
+        let next = point(at: min(index + 1, count - 1))
+
+        return (start,
+                CGPoint(x: start.x + (end.x - previous.x) / 6.0, y: start.y + (end.y - previous.y) / 6.0),
+                CGPoint(x: end.x - (next.x - start.x) / 6.0, y: end.y - (next.y - start.y) / 6.0))
+    }
+
+    private mutating func commit(_ point: SIMD2<Int16>) {
+        committedPoints.append(point)
+        committedHash = (committedHash ^ UInt64(UInt16(bitPattern: point.x))) &* StrokePointStream.hashPrime
+        committedHash = (committedHash ^ UInt64(UInt16(bitPattern: point.y))) &* StrokePointStream.hashPrime
+    }
+
+    private static func encode(_ position: CGPoint) -> SIMD2<Int16> {
+        let limit = CGFloat(Int16.max)
+        return SIMD2(Int16(min(max((position.x * quantizationScale).rounded(), -limit), limit)),
+                     Int16(min(max((position.y * quantizationScale).rounded(), -limit), limit)))
+    }
+
+    private static func decode(_ point: SIMD2<Int16>) -> CGPoint {
+        return CGPoint(x: CGFloat(point.x) / quantizationScale, y: CGFloat(point.y) / quantizationScale)
+    }
+
+    private static func distance(of point: CGPoint, toSegmentFrom start: CGPoint, to end: CGPoint) -> CGFloat {
+        let direction = CGPoint(x: end.x - start.x, y: end.y - start.y)
+        let lengthSquared = direction.x * direction.x + direction.y * direction.y
+        guard lengthSquared > 0.0 else { return hypot(point.x - start.x, point.y - start.y) }
+
+        let projection = min(max(((point.x - start.x) * direction.x + (point.y - start.y) * direction.y)
+                / lengthSquared, 0.0), 1.0)
+        return hypot(point.x - (start.x + direction.x * projection),
+                     point.y - (start.y + direction.y * projection))
+    }
+}
+
+extension StrokePointStream: Hashable, Equatable {
+    static func == (lhs: StrokePointStream, rhs: StrokePointStream) -> Bool {
+        return lhs.committedHash == rhs.committedHash
+            && lhs.tailPoint == rhs.tailPoint
+            && lhs.isFinished == rhs.isFinished
+            && lhs.committedPoints == rhs.committedPoints
+    }
+
+    func hash(into hasher: inout Hasher) {
+        hasher.combine(committedPoints.count)
+        hasher.combine(committedHash)
+        hasher.combine(tailPoint)
+        hasher.combine(isFinished)
+    }
+}
@@ -49,7 +49,7 @@ final class TextLayerModel: LayerModel {
         willSet { textModelEntity.borderSize = newValue as NSNumber }
     }
 
-    init(photoEntity: PhotoEntity, textModelEntity: TextModelEntity) {
+    init(photoEntity: PhotoEntity, textModelEntity: TextModelEntity, isLoadingImage: Bool = true) {
         self.textModelEntity = textModelEntity
         self.text = textModelEntity.text
         self.fontName = textModelEntity.fontName
@@ -59,7 +59,7 @@ final class TextLayerModel: LayerModel {
         self.borderColor = Color(hex: textModelEntity.borderColorHex)
         self.borderSize = textModelEntity.borderSize.intValue
 
-        super.init(photoEntity: photoEntity)
+        super.init(photoEntity: photoEntity, isLoadingImage: isLoadingImage)
         self.photoEntity.photoEntityToTextModelEntity = textModelEntity
     }
 
@@ -67,6 +67,10 @@ final class TextLayerModel: LayerModel {
         return TextLayerModel(photoEntity: photoEntity, textModelEntity: textModelEntity)
     }
 
+    override func copyWithoutImage() -> LayerModel {
+        return TextLayerModel(photoEntity: photoEntity, textModelEntity: textModelEntity, isLoadingImage: false)
+    }
+
     override func copy(withCGImage: Bool, with zone: NSZone? = nil) -> Any {
         let layerModel = copy(with: zone) as! TextLayerModel
         if withCGImage {
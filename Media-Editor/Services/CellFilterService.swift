@@ -0,0 +1,252 @@
+//
+//  CellFilterService.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 09/07/2024.
+//
+
+import CoreGraphics
+import Foundation
+
+struct CellFilterService {
+    private let crystalSeedJitterRange: ClosedRange<Float> = 0.25 ... 0.75
+
+    func canApply(_ filter: FilterType) -> Bool {
+        return switch filter {
+        case .pixellate, .crystalize:
+            true
+        default:
+            false
+        }
+    }
+
+    func applyFilter(_ filter: FilterType,
+                     to image: CGImage,
+                     precision: PixelPrecisionType = .eight) async throws -> CGImage
+    {
+        guard canApply(filter) else { throw PhotoExportError.unsupportedFilter }
+
+        return try await Task {
+            let workingPrecision = precision.deeper(than: PixelPrecisionType(cgImage: image))
+            let source = try PixelBuffer(cgImage: image, precision: workingPrecision)
+            let destination = PixelBuffer(width: source.width, height: source.height, precision: workingPrecision)
+
+            let cellSize = max(1, Int(((filter.parameterValue ?? 1.0)
+                    * filter.sizeCorrectionFactor(for: source.size)).rounded()))
+
+            if case .pixellate = filter {
+                pixellate(source: source, destination: destination, cellSize: cellSize)
+            } else {
+                crystalize(source: source, destination: destination, cellSize: cellSize)
+            }
+
+            return try destination.makeCGImage()
+        }.value
+    }
+
+    private func pixellate(source: PixelBuffer, destination: PixelBuffer, cellSize: Int) {
+        let width = source.width
+        let height = source.height
+        // Deep samples are summed per cell in Double instead: an exact integral image of them would
+        // take 32 bytes a pixel, and pixellate cells never overlap, so each sample is still read once.
+        let integralImage = source.precision == .eight ? createIntegralImage(of: source) : nil
+        defer { integralImage?.deallocate() }
+
+        let integralWidth = width + 1
+        let cellColumns = (width + cellSize - 1) / cellSize
+        let cellRows = (height + cellSize - 1) / cellSize
+
+        DispatchQueue.concurrentPerform(rowCount: cellRows, minimumRowsPerBand: 1) { rows in
+            for cellRow in rows {
+                let minY = cellRow * cellSize
+                let maxY = min(minY + cellSize, height)
+
+                for cellColumn in 0 ..< cellColumns {
+                    let minX = cellColumn * cellSize
+                    let maxX = min(minX + cellSize, width)
+
+                    let average: SIMD4<Float>
+                    if let integralImage {
+                        let sum = integralImage[maxY * integralWidth + maxX]
+                            &- integralImage[minY * integralWidth + maxX]
+                            &- integralImage[maxY * integralWidth + minX]
+                            &+ integralImage[minY * integralWidth + minX]
+
+                        average = SIMD4<Float>(sum) / Float((maxX - minX) * (maxY - minY))
+                    } else {
+                        average = cellAverage(of: source, columns: minX ..< maxX, rows: minY ..< maxY)
+                    }
+
+                    for y in minY ..< maxY {
+                        for x in minX ..< maxX {
+                            destination.setPixel(x: x, y: y, average)
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    private func cellAverage(of source: PixelBuffer, columns: Range<Int>, rows: Range<Int>) -> SIMD4<Float> {
+        var sum = SIMD4<Double>.zero
+        for y in rows {
+            for x in columns {
+                sum += SIMD4<Double>(source.pixel(x: x, y: y))
+            }
+        }
+        return SIMD4<Float>(sum / Double(columns.count * rows.count))
+    }
+
+    // Only built for 8-bit sources, whose raw values sum exactly in wrapping UInt32 lanes.
+    private func createIntegralImage(of source: PixelBuffer) -> UnsafeMutablePointer<SIMD4<UInt32>> {
+        let width = source.width
+        let height = source.height
+        let integralWidth = width + 1
+        let integralImage = UnsafeMutablePointer<SIMD4<UInt32>>.allocate(capacity: integralWidth * (height + 1))
+        integralImage.initialize(repeating: .zero, count: integralWidth * (height + 1))
+
+        DispatchQueue.concurrentPerform(rowCount: height) { rows in
+            for y in rows {
+                var rowSum = SIMD4<UInt32>.zero
+                let rowPointer = source.data + y * source.bytesPerRow
+                for x in 0 ..< width {
+                    let rawPixel = UnsafeRawPointer(rowPointer + x * 4).loadUnaligned(as: SIMD4<UInt8>.self)
+                    rowSum &+= SIMD4<UInt32>(truncatingIfNeeded: rawPixel)
+                    integralImage[(y + 1) * integralWidth + x + 1] = rowSum
+                }
+            }
+        }
+
+        DispatchQueue.concurrentPerform(rowCount: integralWidth) { columns in
+            for y in 1 ... height {
+                for x in columns {
+                    integralImage[y * integralWidth + x] &+= integralImage[(y - 1) * integralWidth + x]
+                }
+            }
+        }
+
+        return integralImage
+    }
+
+    private func crystalize(source: PixelBuffer, destination: PixelBuffer, cellSize: Int) {
+        let width = source.width
+        let height = source.height
+        let gridColumns = (width + cellSize - 1) / cellSize
+        let gridRows = (height + cellSize - 1) / cellSize
+        let seedCount = gridColumns * gridRows
+
+        let seeds = UnsafeMutablePointer<SIMD2<Float>>.allocate(capacity: seedCount)
+        let seedColors = UnsafeMutablePointer<SIMD4<Float>>.allocate(capacity: seedCount)
+        let labels = UnsafeMutablePointer<Int32>.allocate(capacity: width * height)
+        defer {
+            seeds.deallocate()
+            seedColors.deallocate()
+            labels.deallocate()
+        }
+
+        for gridY in 0 ..< gridRows {
+            for gridX in 0 ..< gridColumns {
+                let jitter = crystalSeedJitter(gridX: gridX, gridY: gridY)
+                seeds[gridY * gridColumns + gridX] =
+                    (SIMD2(Float(gridX), Float(gridY)) + jitter) * Float(cellSize)
+            }
+        }
+
+        DispatchQueue.concurrentPerform(rowCount: height) { rows in
+            for y in rows {
+                let gridY = y / cellSize
+                for x in 0 ..< width {
+                    let gridX = x / cellSize
+                    let position = SIMD2<Float>(Float(x), Float(y))
+
+                    var nearestSeed = Int32(gridY * gridColumns + gridX)
+                    var nearestDistance = Float.greatestFiniteMagnitude
+
+                    for neighbourY in max(gridY - 1, 0) ... min(gridY + 1, gridRows - 1) {
+                        for neighbourX in max(gridX - 1, 0) ... min(gridX + 1, gridColumns - 1) {
+                            let seedIndex = neighbourY * gridColumns + neighbourX
+                            let delta = seeds[seedIndex] - position
+                            let distance = (delta * delta).sum()
+                            if distance < nearestDistance {
+                                nearestDistance = distance
+                                nearestSeed = Int32(seedIndex)
+                            }
+                        }
+                    }
+                    labels[y * width + x] = nearestSeed
+                }
+            }
+        }
+
+        DispatchQueue.concurrentPerform(rowCount: gridRows, minimumRowsPerBand: 1) { rows in
+            for gridY in rows {
+                for gridX in 0 ..< gridColumns {
+                    let seedIndex = Int32(gridY * gridColumns + gridX)
+                    var sum = SIMD4<Float>.zero
+                    var count: Float = 0.0
+
+                    let minY = max(gridY - 1, 0) * cellSize
+                    let maxY = min((gridY + 2) * cellSize, height)
+                    let minX = max(gridX - 1, 0) * cellSize
+                    let maxX = min((gridX + 2) * cellSize, width)
+
+                    for y in minY ..< maxY {
+                        for x in minX ..< maxX where labels[y * width + x] == seedIndex {
+                            sum += source.pixel(x: x, y: y)
+                            count += 1.0
+                        }
+                    }
+                    seedColors[Int(seedIndex)] = count > 0.0 ? sum / count : .zero
+                }
+            }
+        }
+
+        DispatchQueue.concurrentPerform(rowCount: height) { rows in
+            for y in rows {
+                for x in 0 ..< width {
+                    destination.setPixel(x: x, y: y, seedColors[Int(labels[y * width + x])])
+                }
+            }
+        }
+    }
+
+    private func crystalSeedJitter(gridX: Int, gridY: Int) -> SIMD2<Float> {
+        var hash = UInt32(truncatingIfNeeded: gridX &* 73_856_093 ^ gridY &* 19_349_663)
+        hash = (hash ^ (hash >> 16)) &* 0x45D9_F3B
+        hash = (hash ^ (hash >> 16)) &* 0x45D9_F3B
+        hash ^= hash >> 16
+
+        let unitX = Float(hash & 0xFFFF) / Float(0xFFFF)
+        let unitY = Float(hash >> 16) / Float(0xFFFF)
+        let jitterSpan = crystalSeedJitterRange.upperBound - crystalSeedJitterRange.lowerBound
+
+        return SIMD2(crystalSeedJitterRange.lowerBound + unitX * jitterSpan,
+                     crystalSeedJitterRange.lowerBound + unitY * jitterSpan)
+    }
+}
+
+#if DEBUG
+extension CellFilterService {
+    func runBenchmark(sizes: [CGSize] = [CGSize(width: 1000, height: 750),
+                                         CGSize(width: 4000, height: 3000),
+                                         CGSize(width: 8000, height: 6000)]) async throws
+    {
+        for size in sizes {
+            let buffer = PixelBuffer(width: Int(size.width), height: Int(size.height))
+            for y in 0 ..< buffer.height {
+                for x in 0 ..< buffer.width {
+                    buffer.setPixel(x: x, y: y, SIMD4(Float(x % 256), Float(y % 256), Float((x ^ y) % 256), 255.0))
+                }
+            }
+            let image = try buffer.makeCGImage()
+
+            for filter in [FilterType.pixellate(value: 30.0), FilterType.crystalize(value: 30.0)] {
+                print(filter.shortName, Int(size.width), "x", Int(size.height))
+                _ = try await MeasureUtilities.functionTime {
+                    try await applyFilter(filter, to: image)
+                }
+            }
+        }
+    }
+}
+#endif
@@ -0,0 +1,159 @@
+//
+//  ColorLookupTableService.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 10/07/2024.
+//
+
+import CoreImage
+import Foundation
+
+final class ColorLookupTableService {
+    private let lookupTableCache = NSCache<NSString, ColorLookupTable>()
+    private let lookupTableDimension: Int
+    private let folderName = "ColorLookupTables"
+
+    init(lookupTableDimension: Int = 33) {
+        self.lookupTableDimension = lookupTableDimension
+    }
+
+    func canApply(_ filter: FilterType) -> Bool {
+        return filter.category == .effect
+    }
+
+    func applyFilter(_ filter: FilterType,
+                     to image: CGImage,
+                     precision: PixelPrecisionType = .eight) async throws -> CGImage
+    {
+        guard canApply(filter) else { throw PhotoExportError.unsupportedFilter }
+
+        return try await Task {
+            let workingPrecision = precision.deeper(than: PixelPrecisionType(cgImage: image))
+            let lookupTable = try self.lookupTable(for: filter)
+            let buffer = try PixelBuffer(cgImage: image, precision: workingPrecision)
+
+            apply(lookupTable: lookupTable, to: buffer)
+
+            return try buffer.makeCGImage()
+        }.value
+    }
+
+    func lookupTable(for filter: FilterType) throws -> ColorLookupTable {
+        let workingColorSpace = ColorManagementService.shared.workingColorSpace
+        let key = "\(filter.filterName)-\(lookupTableDimension)-\(workingColorSpace.name as String? ?? "device")" as NSString
+
+        if let cachedLookupTable = lookupTableCache.object(forKey: key) {
+            return cachedLookupTable
+        }
+
+        let fileURL = try lookupTableFileURL(fileName: key as String)
+
+        let lookupTable: ColorLookupTable
+        if let data = try? Data(contentsOf: fileURL),
+           let storedLookupTable = try? ColorLookupTable(data: data),
+           storedLookupTable.dimension == lookupTableDimension
+        {
+            lookupTable = storedLookupTable
+        } else {
+            lookupTable = try bakeLookupTable(for: filter)
+            try? lookupTable.binaryRepresentation.write(to: fileURL, options: .atomic)
+        }
+
+        lookupTableCache.setObject(lookupTable, forKey: key)
+        return lookupTable
+    }
+
+    private func lookupTableFileURL(fileName: String) throws -> URL {
+        guard let cachesDirectory = FileManager.default.urls(for: .cachesDirectory, in: .userDomainMask).first else {
+            throw FileError.documentDirectory
+        }
+
+        let folderURL = cachesDirectory.appendingPathComponent(folderName)
+        do {
+            try FileManager.default.createDirectory(at: folderURL, withIntermediateDirectories: true, attributes: nil)
+        } catch {
+            throw FileError.subdirectory
+        }
+
+        return folderURL.appendingPathComponent(fileName).appendingPathExtension("lut")
+    }
+
+    private func bakeLookupTable(for filter: FilterType) throws -> ColorLookupTable {
+        let dimension = lookupTableDimension
+        let width = dimension
+        let height = dimension * dimension
+        let bitmapInfo = CGImageAlphaInfo.premultipliedLast.rawValue | CGBitmapInfo.byteOrder16Little.rawValue
+        let workingColorSpace = ColorManagementService.shared.workingColorSpace
+
+        guard let latticeContext = CGContext(data: nil,
+                                             width: width,
+                                             height: height,
+                                             bitsPerComponent: 16,
+                                             bytesPerRow: width * 8,
+                                             space: workingColorSpace,
+                                             bitmapInfo: bitmapInfo),
+            let latticeData = latticeContext.data?.bindMemory(to: UInt16.self, capacity: width * height * 4)
+        else {
+            throw PhotoExportError.contextCreation(contextSize: CGSize(width: width, height: height))
+        }
+
+        let maxValue = Float(UInt16.max)
+        let step = maxValue / Float(dimension - 1)
+
+        for blue in 0 ..< dimension {
+            for green in 0 ..< dimension {
+                for red in 0 ..< dimension {
+                    let offset = ((blue * dimension + green) * dimension + red) * 4
+                    latticeData[offset] = UInt16((Float(red) * step).rounded())
+                    latticeData[offset + 1] = UInt16((Float(green) * step).rounded())
+                    latticeData[offset + 2] = UInt16((Float(blue) * step).rounded())
+                    latticeData[offset + 3] = UInt16.max
+                }
+            }
+        }
+
+        guard let latticeImage = latticeContext.makeImage() else { throw PhotoExportError.contextImageMaking }
+
+        let ciImage = CIImage(cgImage: latticeImage)
+        guard let outputImage = filter.createFilter(image: ciImage).outputImage?.cropped(to: ciImage.extent),
+              let filteredImage = CIContext().createCGImage(outputImage,
+                                                            from: ciImage.extent,
+                                                            format: .RGBA16,
+                                                            colorSpace: workingColorSpace)
+        else { throw PhotoExportError.contextImageMaking }
+
+        latticeContext.clear(CGRect(x: 0, y: 0, width: width, height: height))
+        latticeContext.draw(filteredImage, in: CGRect(x: 0, y: 0, width: width, height: height))
+
+        let values = (0 ..< width * height).map { index in
+            SIMD4<Float>(Float(latticeData[index * 4]),
+                         Float(latticeData[index * 4 + 1]),
+                         Float(latticeData[index * 4 + 2]),
+                         maxValue) / maxValue
+        }
+
+        return ColorLookupTable(dimension: dimension, values: values)
+    }
+
+    private func apply(lookupTable: ColorLookupTable, to buffer: PixelBuffer) {
+        let width = buffer.width
+
+        lookupTable.values.withUnsafeBufferPointer { values in
+            DispatchQueue.concurrentPerform(rowCount: buffer.height) { rows in
+                for y in rows {
+                    for x in 0 ..< width {
+                        let premultipliedPixel = buffer.pixel(x: x, y: y)
+                        let alpha = premultipliedPixel.w
+                        guard alpha > 0.0 else { continue }
+
+                        let color = premultipliedPixel / alpha
+                        var mappedColor = lookupTable.tetrahedralLookup(color, in: values) * alpha
+                        mappedColor.w = alpha
+
+                        buffer.setPixel(x: x, y: y, mappedColor)
+                    }
+                }
+            }
+        }
+    }
+}
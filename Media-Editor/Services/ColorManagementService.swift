@@ -0,0 +1,91 @@
+//
+//  ColorManagementService.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 23/07/2024.
+//
+
+import CoreGraphics
+import Foundation
+
+final class ColorManagementService {
+    static let shared = ColorManagementService()
+
+    private(set) var workingColorSpace: CGColorSpace
+    private var workingProfile: ColorTransform.Profile
+
+    private var transforms = [String: ColorTransform]()
+    private let lock = NSLock()
+
+    private init() {
+        self.workingColorSpace = CGColorSpace(name: CGColorSpace.displayP3)!
+        self.workingProfile = .displayP3
+    }
+
+    func setWorkingColorSpace(_ colorSpace: CGColorSpace) {
+        guard let profile = ColorTransform.Profile(colorSpace: colorSpace) else { return }
+
+        lock.lock()
+        workingColorSpace = colorSpace
+        workingProfile = profile
+        lock.unlock()
+    }
+
+    func isInWorkingColorSpace(_ image: CGImage) -> Bool {
+        guard let colorSpace = image.colorSpace else { return false }
+        return colorSpace.name == workingColorSpace.name
+    }
+
+    // Converts once from the image's tagged space, so later draws into working-space
+    // contexts need no implicit per-draw matching.
+    func convertToWorkingColorSpace(_ image: CGImage) throws -> CGImage {
+        guard !isInWorkingColorSpace(image) else { return image }
+
+        let precision = PixelPrecisionType(cgImage: image)
+
+        guard let sourceColorSpace = image.colorSpace,
+              let sourceProfile = ColorTransform.Profile(colorSpace: sourceColorSpace)
+        else {
+            let buffer = try PixelBuffer(cgImage: image, precision: precision, colorSpace: workingColorSpace)
+            return try buffer.makeCGImage()
+        }
+
+        let buffer = try PixelBuffer(cgImage: image, precision: precision, colorSpace: sourceColorSpace)
+        transform(from: sourceProfile, named: sourceColorSpace.name as String? ?? "device")
+            .apply(to: buffer)
+
+        return try buffer.makeCGImage(colorSpace: workingColorSpace)
+    }
+
+    // UI colours are specified in (extended) sRGB; pixel buffers hold working-space components.
+    func workingComponents(of color: CGColor) -> SIMD4<Float> {
+        let workingColor = color.converted(to: workingColorSpace, intent: .defaultIntent, options: nil) ?? color
+        guard let components = workingColor.components else { return .zero }
+
+        switch components.count {
+        case 2:
+            return SIMD4(Float(components[0]), Float(components[0]), Float(components[0]), Float(components[1]))
+        case 4...:
+            return SIMD4(Float(components[0]), Float(components[1]), Float(components[2]), Float(components[3]))
+        default:
+            return .zero
+        }
+    }
+
+    func workingColor(red: Float, green: Float, blue: Float, alpha: Float) -> CGColor? {
+        return CGColor(colorSpace: workingColorSpace,
+                       components: [CGFloat(red), CGFloat(green), CGFloat(blue), CGFloat(alpha)])
+    }
+
+    private func transform(from sourceProfile: ColorTransform.Profile, named sourceName: String) -> ColorTransform {
+        lock.lock()
+        defer { lock.unlock() }
+
+        let key = "\(sourceName)-\(workingColorSpace.name as String? ?? "device")"
+        if let transform = transforms[key] { return transform }
+
+        let transform = ColorTransform(from: sourceProfile, to: workingProfile)
+        transforms[key] = transform
+        return transform
+    }
+}
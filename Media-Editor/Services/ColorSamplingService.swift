@@ -0,0 +1,98 @@
+//
+//  ColorSamplingService.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 20/07/2024.
+//
+
+import SwiftUI
+
+final class ColorSamplingService {
+    enum SampleSize: Int, CaseIterable {
+        case single = 1
+        case threeByThree = 3
+        case fiveByFive = 5
+
+        var radius: Int { return rawValue / 2 }
+    }
+
+    let maxDimension: Int
+
+    private var pixelView: PixelBuffer?
+    private var sampledRect: CGRect = .zero
+    private var isPixelViewStale = true
+    private let lock = NSLock()
+
+    init(maxDimension: Int = 512) {
+        self.maxDimension = maxDimension
+    }
+
+    var isStale: Bool {
+        lock.lock()
+        defer { lock.unlock() }
+        return isPixelViewStale
+    }
+
+    func renderScale(for pixelSize: CGSize) -> CGFloat {
+        return min(1.0, CGFloat(maxDimension) / max(pixelSize.width, pixelSize.height, 1.0))
+    }
+
+    func invalidate() {
+        lock.lock()
+        isPixelViewStale = true
+        lock.unlock()
+    }
+
+    func update(with composite: CGImage, covering rect: CGRect) async throws {
+        let pixelView = try await Task {
+            let scale = self.renderScale(for: CGSize(width: composite.width, height: composite.height))
+            let pixelView = PixelBuffer(width: max(1, Int((CGFloat(composite.width) * scale).rounded())),
+                                        height: max(1, Int((CGFloat(composite.height) * scale).rounded())))
+
+            let context = try pixelView.createContext()
+            context.interpolationQuality = .medium
+            context.draw(composite, in: CGRect(origin: .zero, size: pixelView.size))
+            return pixelView
+        }.value
+
+        lock.lock()
+        self.pixelView = pixelView
+        sampledRect = rect
+        isPixelViewStale = false
+        lock.unlock()
+    }
+
+    func color(at point: CGPoint, sampleSize: SampleSize = .threeByThree) -> Color? {
+        lock.lock()
+        defer { lock.unlock() }
+
+        guard let pixelView, sampledRect.contains(point) else { return nil }
+
+        let centerX = min(Int((point.x - sampledRect.minX) / sampledRect.width * CGFloat(pixelView.width)),
+                          pixelView.width - 1)
+        let centerY = min(Int((point.y - sampledRect.minY) / sampledRect.height * CGFloat(pixelView.height)),
+                          pixelView.height - 1)
+
+        let radius = sampleSize.radius
+        var sum = SIMD4<Float>.zero
+        var sampleCount: Float = 0.0
+
+        for y in max(0, centerY - radius) ... min(pixelView.height - 1, centerY + radius) {
+            for x in max(0, centerX - radius) ... min(pixelView.width - 1, centerX + radius) {
+                sum += pixelView.pixel(x: x, y: y)
+                sampleCount += 1.0
+            }
+        }
+
+        let average = sum / (sampleCount * 255.0)
+        guard average.w > 0.0 else { return .clear }
+
+        guard let workingColor = ColorManagementService.shared.workingColor(red: average.x / average.w,
+                                                                             green: average.y / average.w,
+                                                                             blue: average.z / average.w,
+                                                                             alpha: average.w)
+        else { return .clear }
+
+        return Color(cgColor: workingColor)
+    }
+}
@@ -0,0 +1,308 @@
+//
+//  CropMaskRasterizerService.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 13/07/2024.
+//
+
+import CoreGraphics
+import Foundation
+
+struct CropMaskRasterizerService {
+    private struct Edge {
+        let start: SIMD2<Float>
+        let end: SIMD2<Float>
+        let direction: Float
+    }
+
+    private let flatteningTolerance: Float = 0.1
+    private let maxCurveSubdivisions = 1024
+    private let rowsPerBand = 64
+
+    func applyMask(path: CGPath, fillRule: CGPathFillRule = .winding, to context: CGContext) throws {
+        guard let data = context.data,
+              [32, 64].contains(context.bitsPerPixel)
+        else { throw PhotoExportError.contextCreation(contextSize: CGSize(width: context.width, height: context.height)) }
+
+        let precision: PixelPrecisionType = if context.bitsPerPixel == 32 {
+            .eight
+        } else {
+            context.bitmapInfo.contains(.floatComponents) ? .halfFloat : .sixteen
+        }
+
+        let width = context.width
+        let height = context.height
+        let bytesPerRow = context.bytesPerRow
+        let edges = createEdges(of: path, width: width, height: height)
+
+        DispatchQueue.concurrentPerform(rowCount: height, minimumRowsPerBand: rowsPerBand) { rows in
+            let mask = UnsafeMutablePointer<UInt8>.allocate(capacity: width * rows.count)
+            defer { mask.deallocate() }
+
+            rasterize(edges: edges, rows: rows, width: width, fillRule: fillRule, into: mask)
+
+            for y in rows {
+                let row = data + y * bytesPerRow
+                let rowMask = mask + (y - rows.lowerBound) * width
+
+                switch precision {
+                case .eight:
+                    multiply(row: row.assumingMemoryBound(to: UInt8.self), by: rowMask, width: width)
+                case .sixteen:
+                    multiply(row: row.assumingMemoryBound(to: SIMD4<UInt16>.self), by: rowMask, width: width)
+                case .halfFloat:
+                    multiply(row: row.assumingMemoryBound(to: SIMD4<Float16>.self), by: rowMask, width: width)
+                }
+            }
+        }
+    }
+
+    func createMask(path: CGPath, fillRule: CGPathFillRule = .winding, width: Int, height: Int) -> [UInt8] {
+        let edges = createEdges(of: path, width: width, height: height)
+        var mask = [UInt8](repeating: 0, count: width * height)
+
+        mask.withUnsafeMutableBufferPointer { maskBuffer in
+            guard let maskPointer = maskBuffer.baseAddress else { return }
+            DispatchQueue.concurrentPerform(rowCount: height, minimumRowsPerBand: rowsPerBand) { rows in
+                rasterize(edges: edges, rows: rows, width: width, fillRule: fillRule,
+                          into: maskPointer + rows.lowerBound * width)
+            }
+        }
+        return mask
+    }
+
+    private func createEdges(of path: CGPath, width: Int, height: Int) -> [Edge] {
+        var edges: [Edge] = []
+        var subpathStart = SIMD2<Float>.zero
+        var currentPoint = SIMD2<Float>.zero
+
+        let toMaskSpace = { (point: CGPoint) in
+            SIMD2<Float>(Float(point.x), Float(height) - Float(point.y))
+        }
+
+        let addLine = { (start: SIMD2<Float>, end: SIMD2<Float>) in
+            appendClippedEdges(from: start, to: end, width: Float(width), into: &edges)
+        }
+
+        path.applyWithBlock { elementPointer in
+            let element = elementPointer.pointee
+            switch element.type {
+            case .moveToPoint:
+                addLine(currentPoint, subpathStart)
+                subpathStart = toMaskSpace(element.points[0])
+                currentPoint = subpathStart
+            case .addLineToPoint:
+                let point = toMaskSpace(element.points[0])
+                addLine(currentPoint, point)
+                currentPoint = point
+            case .addQuadCurveToPoint:
+                let control = toMaskSpace(element.points[0])
+                let end = toMaskSpace(element.points[1])
+                let deviation = currentPoint - 2.0 * control + end
+                let subdivisions = curveSubdivisions(for: 0.25 * (deviation * deviation).sum().squareRoot())
+                let start = currentPoint
+
+                for step in 1 ... subdivisions {
+                    let t = Float(step) / Float(subdivisions)
+                    let point = start * ((1.0 - t) * (1.0 - t)) + control * (2.0 * (1.0 - t) * t) + end * (t * t)
+                    addLine(currentPoint, point)
+                    currentPoint = point
+                }
+            case .addCurveToPoint:
+                let control1 = toMaskSpace(element.points[0])
+                let control2 = toMaskSpace(element.points[1])
+                let end = toMaskSpace(element.points[2])
+                let firstDeviation = currentPoint - 2.0 * control1 + control2
+                let secondDeviation = control1 - 2.0 * control2 + end
+                let subdivisions = curveSubdivisions(
+                    for: 0.75 * max((firstDeviation * firstDeviation).sum(), (secondDeviation * secondDeviation).sum())
+                        .squareRoot())
+                let start = currentPoint
+
+                for step in 1 ... subdivisions {
+                    let t = Float(step) / Float(subdivisions)
+                    let inverseT = 1.0 - t
+                    let point = start * (inverseT * inverseT * inverseT)
+                        + control1 * (3.0 * inverseT * inverseT * t)
+                        + control2 * (3.0 * inverseT * t * t)
+                        + end * (t * t * t)
+                    addLine(currentPoint, point)
+                    currentPoint = point
+                }
+            case .closeSubpath:
+                addLine(currentPoint, subpathStart)
+                currentPoint = subpathStart
+            @unknown default:
+                break
+            }
+        }
+        addLine(currentPoint, subpathStart)
+
+        return edges
+    }
+
+    private func curveSubdivisions(for deviation: Float) -> Int {
+        return min(max(Int((deviation / flatteningTolerance).squareRoot().rounded(.up)), 1), maxCurveSubdivisions)
+    }
+
+    private func appendClippedEdges(from start: SIMD2<Float>, to end: SIMD2<Float>, width: Float, into edges: inout [Edge]) {
+        guard start.y != end.y else { return }
+
+        let direction: Float = start.y < end.y ? 1.0 : -1.0
+        let (top, bottom) = start.y < end.y ? (start, end) : (end, start)
+
+        var splitParameters: [Float] = [0.0, 1.0]
+        for boundary: Float in [0.0, width] where (top.x - boundary) * (bottom.x - boundary) < 0.0 {
+            splitParameters.append((boundary - top.x) / (bottom.x - top.x))
+        }
+        splitParameters.sort()
+
+        for index in 1 ..< splitParameters.count {
+            var pieceStart = top + (bottom - top) * splitParameters[index - 1]
+            var pieceEnd = top + (bottom - top) * splitParameters[index]
+            pieceStart.x = min(max(pieceStart.x, 0.0), width)
+            pieceEnd.x = min(max(pieceEnd.x, 0.0), width)
+
+            if pieceStart.y < pieceEnd.y {
+                edges.append(Edge(start: pieceStart, end: pieceEnd, direction: direction))
+            }
+        }
+    }
+
+    private func rasterize(edges: [Edge],
+                           rows: Range<Int>,
+                           width: Int,
+                           fillRule: CGPathFillRule,
+                           into mask: UnsafeMutablePointer<UInt8>)
+    {
+        let accumulationWidth = width + 2
+        let accumulation = UnsafeMutablePointer<Float>.allocate(capacity: accumulationWidth * rows.count)
+        accumulation.initialize(repeating: 0.0, count: accumulationWidth * rows.count)
+        defer { accumulation.deallocate() }
+
+        let bandTop = Float(rows.lowerBound)
+        let bandBottom = Float(rows.upperBound)
+
+        for edge in edges where edge.end.y > bandTop && edge.start.y < bandBottom {
+            accumulate(edge: edge, rows: rows, accumulation: accumulation, accumulationWidth: accumulationWidth)
+        }
+
+        for y in 0 ..< rows.count {
+            let accumulationRow = accumulation + y * accumulationWidth
+            let maskRow = mask + y * width
+            var winding: Float = 0.0
+
+            for x in 0 ..< width {
+                winding += accumulationRow[x]
+                let coverage: Float
+                if fillRule == .evenOdd {
+                    let remainder = abs(winding).truncatingRemainder(dividingBy: 2.0)
+                    coverage = 1.0 - abs(1.0 - remainder)
+                } else {
+                    coverage = min(abs(winding), 1.0)
+                }
+                maskRow[x] = UInt8(coverage * 255.0 + 0.5)
+            }
+        }
+    }
+
+    private func accumulate(edge: Edge,
+                            rows: Range<Int>,
+                            accumulation: UnsafeMutablePointer<Float>,
+                            accumulationWidth: Int)
+    {
+        let slope = (edge.end.x - edge.start.x) / (edge.end.y - edge.start.y)
+        let firstRow = max(Int(edge.start.y.rounded(.down)), rows.lowerBound)
+        let lastRow = min(Int(edge.end.y.rounded(.up)), rows.upperBound)
+        guard firstRow < lastRow else { return }
+
+        var x = edge.start.x + slope * (max(Float(firstRow), edge.start.y) - edge.start.y)
+
+        for y in firstRow ..< lastRow {
+            let row = accumulation + (y - rows.lowerBound) * accumulationWidth
+            let rowHeight = min(Float(y + 1), edge.end.y) - max(Float(y), edge.start.y)
+            let nextX = x + slope * rowHeight
+            let signedHeight = rowHeight * edge.direction
+
+            let (left, right) = x < nextX ? (x, nextX) : (nextX, x)
+            let leftFloor = left.rounded(.down)
+            let leftIndex = Int(leftFloor)
+            let rightCeil = right.rounded(.up)
+            let rightIndex = Int(rightCeil)
+
+            if rightIndex <= leftIndex + 1 {
+                let midFraction = 0.5 * (x + nextX) - leftFloor
+                row[leftIndex] += signedHeight * (1.0 - midFraction)
+                row[leftIndex + 1] += signedHeight * midFraction
+            } else {
+                let inverseSpan = 1.0 / (right - left)
+                let leftFraction = left - leftFloor
+                let leftArea = 0.5 * inverseSpan * (1.0 - leftFraction) * (1.0 - leftFraction)
+                let rightFraction = right - rightCeil + 1.0
+                let rightArea = 0.5 * inverseSpan * rightFraction * rightFraction
+
+                row[leftIndex] += signedHeight * leftArea
+                if rightIndex == leftIndex + 2 {
+                    row[leftIndex + 1] += signedHeight * (1.0 - leftArea - rightArea)
+                } else {
+                    let firstArea = inverseSpan * (1.5 - leftFraction)
+                    row[leftIndex + 1] += signedHeight * (firstArea - leftArea)
+                    for index in leftIndex + 2 ..< rightIndex - 1 {
+                        row[index] += signedHeight * inverseSpan
+                    }
+                    let lastArea = firstArea + Float(rightIndex - leftIndex - 3) * inverseSpan
+                    row[rightIndex - 1] += signedHeight * (1.0 - lastArea - rightArea)
+                }
+                row[rightIndex] += signedHeight * rightArea
+            }
+            x = nextX
+        }
+    }
+
+    private func multiply(row: UnsafeMutablePointer<UInt8>, by mask: UnsafePointer<UInt8>, width: Int) {
+        let rounding = SIMD16<UInt16>(repeating: 128)
+        var x = 0
+
+        while x + 4 <= width {
+            let coverage = UnsafeRawPointer(mask + x).loadUnaligned(as: SIMD4<UInt8>.self)
+            let pixels = UnsafeMutableRawPointer(row + x * 4)
+
+            if coverage == SIMD4(repeating: 0) {
+                pixels.storeBytes(of: SIMD16<UInt8>(repeating: 0), as: SIMD16<UInt8>.self)
+            } else if coverage != SIMD4(repeating: 255) {
+                let expandedCoverage = SIMD16<UInt16>(
+                    lowHalf: SIMD8(lowHalf: SIMD4(repeating: UInt16(coverage[0])),
+                                   highHalf: SIMD4(repeating: UInt16(coverage[1]))),
+                    highHalf: SIMD8(lowHalf: SIMD4(repeating: UInt16(coverage[2])),
+                                    highHalf: SIMD4(repeating: UInt16(coverage[3]))))
+                let product = SIMD16<UInt16>(truncatingIfNeeded: pixels.loadUnaligned(as: SIMD16<UInt8>.self))
+                    &* expandedCoverage &+ rounding
+                let result = (product &+ (product &>> 8)) &>> 8
+                pixels.storeBytes(of: SIMD16<UInt8>(truncatingIfNeeded: result), as: SIMD16<UInt8>.self)
+            }
+            x += 4
+        }
+
+        while x < width {
+            let coverage = UInt16(mask[x])
+            for channel in 0 ..< 4 {
+                let product = UInt16(row[x * 4 + channel]) * coverage + 128
+                row[x * 4 + channel] = UInt8((product + (product >> 8)) >> 8)
+            }
+            x += 1
+        }
+    }
+
+    private func multiply(row: UnsafeMutablePointer<SIMD4<UInt16>>, by mask: UnsafePointer<UInt8>, width: Int) {
+        for x in 0 ..< width where mask[x] != 255 {
+            let product = SIMD4<UInt32>(truncatingIfNeeded: row[x]) &* UInt32(mask[x]) &+ 127
+            row[x] = SIMD4<UInt16>(truncatingIfNeeded: product / 255)
+        }
+    }
+
+    private func multiply(row: UnsafeMutablePointer<SIMD4<Float16>>, by mask: UnsafePointer<UInt8>, width: Int) {
+        for x in 0 ..< width where mask[x] != 255 {
+            row[x] = SIMD4<Float16>(SIMD4<Float>(row[x]) * (Float(mask[x]) * (1.0 / 255.0)))
+        }
+    }
+}
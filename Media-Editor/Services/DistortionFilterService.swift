@@ -0,0 +1,186 @@
+//
+//  DistortionFilterService.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 08/07/2024.
+//
+
+import CoreGraphics
+import Foundation
+
+final class DistortionFilterService {
+    private let imageCache = ImageCacheService.shared
+    private let cacheKeyPrefix = "distortion/"
+
+    private let bumpScale: Float = 0.5
+    private let glassScaleFactor: Float = 0.01
+    private let lightTunnelRotation: Float = 45.0
+    private let maxBlurTapCount = 32
+    private let zoomBlurTapCount = 24
+
+    func canApply(_ filter: FilterType) -> Bool {
+        return switch filter {
+        case .bump,
+             .bumpLinear,
+             .circleSplash,
+             .glass,
+             .lightTunnel,
+             .zoomBlur,
+             .motionBlur:
+            true
+        default:
+            false
+        }
+    }
+
+    func applyFilter(_ filter: FilterType,
+                     to image: CGImage,
+                     precision: PixelPrecisionType = .eight) async throws -> CGImage
+    {
+        guard canApply(filter) else { throw PhotoExportError.unsupportedFilter }
+
+        return try await Task {
+            let workingPrecision = precision.deeper(than: PixelPrecisionType(cgImage: image))
+            let source = try PixelBuffer(cgImage: image, precision: workingPrecision)
+            let field = displacementField(for: filter, source: source, sourceImage: image)
+            let destination = PixelBuffer(width: source.width, height: source.height, precision: workingPrecision)
+
+            remap(source: source, destination: destination, field: field)
+
+            return try destination.makeCGImage()
+        }.value
+    }
+
+    func removeCachedFields() {
+        imageCache.removeObjects(in: .renderGraph, withKeyPrefix: cacheKeyPrefix)
+    }
+
+    private func cacheKey(for filter: FilterType, width: Int, height: Int) -> String {
+        return "\(cacheKeyPrefix)\(filter.thumbnailName)-\(filter.parameterValue ?? 0.0)-\(width)x\(height)"
+    }
+
+    private func displacementField(for filter: FilterType, source: PixelBuffer, sourceImage: CGImage) -> DisplacementField {
+        let key = cacheKey(for: filter, width: source.width, height: source.height)
+
+        if let cachedField: DisplacementField = imageCache.object(forKey: key, in: .renderGraph) {
+            if case .glass = filter {
+                if cachedField.texture === sourceImage { return cachedField }
+            } else {
+                return cachedField
+            }
+        }
+
+        let field = createDisplacementField(for: filter, source: source, sourceImage: sourceImage)
+        imageCache.setObject(field, forKey: key, in: .renderGraph, cost: field.byteCost)
+        return field
+    }
+
+    private func createDisplacementField(for filter: FilterType, source: PixelBuffer, sourceImage: CGImage) -> DisplacementField {
+        let width = source.width
+        let height = source.height
+        let center = SIMD2<Float>(Float(width) * 0.5, Float(height) * 0.5)
+        let diagonal = Float(hypot(CGFloat(width), CGFloat(height)))
+        let value = Float((filter.parameterValue ?? 0.0) * filter.sizeCorrectionFactor(for: source.size))
+
+        let field: DisplacementField
+        switch filter {
+        case .motionBlur:
+            field = DisplacementField(width: width, height: height,
+                                      tapCount: min(max(Int(value * 0.5), 2), maxBlurTapCount))
+        case .zoomBlur:
+            field = DisplacementField(width: width, height: height, tapCount: zoomBlurTapCount)
+        case .glass:
+            field = DisplacementField(width: width, height: height, texture: sourceImage)
+        default:
+            field = DisplacementField(width: width, height: height)
+        }
+
+        let origins = field.origins
+        let steps = field.steps
+        let tapCount = Float(field.tapCount)
+
+        DispatchQueue.concurrentPerform(rowCount: height) { rows in
+            for y in rows {
+                for x in 0 ..< width {
+                    let index = y * width + x
+                    let position = SIMD2<Float>(Float(x), Float(y))
+                    let delta = position - center
+                    let distance = (delta * delta).sum().squareRoot()
+
+                    switch filter {
+                    case .bump:
+                        if distance < value {
+                            let falloff = 1.0 - distance / value
+                            origins[index] = center + delta * (1.0 - bumpScale * falloff * falloff)
+                        } else {
+                            origins[index] = position
+                        }
+                    case .bumpLinear:
+                        let lineDistance = abs(delta.y)
+                        if lineDistance < value {
+                            let falloff = 1.0 - lineDistance / value
+                            origins[index] = SIMD2(position.x,
+                                                   center.y + delta.y * (1.0 - bumpScale * falloff * falloff))
+                        } else {
+                            origins[index] = position
+                        }
+                    case .circleSplash:
+                        if distance > value, distance > 0.0 {
+                            origins[index] = center + delta * (value / distance)
+                        } else {
+                            origins[index] = position
+                        }
+                    case .lightTunnel:
+                        if distance > value, distance > 0.0 {
+                            let angle = atan2(delta.y, delta.x) + lightTunnelRotation * (1.0 - value / distance)
+                            origins[index] = center + SIMD2(cos(angle), sin(angle)) * value
+                        } else {
+                            origins[index] = position
+                        }
+                    case .glass:
+                        let gradient = SIMD2<Float>(source.luminance(x: x + 1, y: y) - source.luminance(x: x - 1, y: y),
+                                                    source.luminance(x: x, y: y + 1) - source.luminance(x: x, y: y - 1))
+                        origins[index] = position + gradient * value * glassScaleFactor
+                    case .motionBlur:
+                        origins[index] = SIMD2(position.x - value, position.y)
+                        steps?[index] = SIMD2(2.0 * value / (tapCount - 1.0), 0.0)
+                    case .zoomBlur:
+                        let spread = min(value / (diagonal * 0.5), 1.0)
+                        origins[index] = position
+                        steps?[index] = -delta * (spread / tapCount)
+                    default:
+                        origins[index] = position
+                    }
+                }
+            }
+        }
+
+        return field
+    }
+
+    private func remap(source: PixelBuffer, destination: PixelBuffer, field: DisplacementField) {
+        let width = destination.width
+        let tapWeight = SIMD4<Float>(repeating: 1.0 / Float(field.tapCount))
+
+        DispatchQueue.concurrentPerform(rowCount: destination.height) { rows in
+            for y in rows {
+                for x in 0 ..< width {
+                    let index = y * width + x
+                    let origin = field.origins[index]
+
+                    if let steps = field.steps {
+                        let step = steps[index]
+                        var accumulator = SIMD4<Float>.zero
+                        for tap in 0 ..< field.tapCount {
+                            let samplePosition = origin + step * Float(tap)
+                            accumulator += source.bilinearSample(x: samplePosition.x, y: samplePosition.y)
+                        }
+                        destination.setPixel(x: x, y: y, accumulator * tapWeight)
+                    } else {
+                        destination.setPixel(x: x, y: y, source.bilinearSample(x: origin.x, y: origin.y))
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,110 @@
+//
+//  EditStackRenderService.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 24/07/2024.
+//
+
+import CoreGraphics
+import CoreImage
+import Foundation
+
+final class EditStackRenderService {
+    private let distortionFilterService = DistortionFilterService()
+    private let cellFilterService = CellFilterService()
+    private let colorLookupTableService = ColorLookupTableService()
+
+    // Every applied prefix of a layer's stack is a node of the render graph,
+    // so replay resumes from the deepest cached node instead of the checkpoint.
+    private let imageCache = ImageCacheService.shared
+    private let cacheKeyPrefix = "editStack/"
+
+    func render(_ editStack: EditStack,
+                of layer: LayerModel,
+                precision: PixelPrecisionType = .eight) async throws -> CGImage?
+    {
+        let checkpointPosition = (editStack.lastCheckpoint?.index ?? -1) + 1
+
+        var position = editStack.position
+        var image = cachedImage(for: layer.fileName, editStack: editStack, upTo: position)
+
+        while image == nil, position > checkpointPosition {
+            position -= 1
+            image = cachedImage(for: layer.fileName, editStack: editStack, upTo: position)
+        }
+
+        if image == nil {
+            image = layer.checkpointCGImage(of: editStack)
+            if let image {
+                store(image, for: layer.fileName, editStack: editStack, upTo: position)
+            }
+        }
+
+        guard var image else { return nil }
+
+        for operation in editStack.operations[position ..< editStack.position] {
+            guard case .filter(let filter) = operation else { continue }
+
+            image = try await applyFilter(filter, to: image, precision: precision)
+            position += 1
+            store(image, for: layer.fileName, editStack: editStack, upTo: position)
+        }
+
+        return image
+    }
+
+    func store(_ image: CGImage, for layerID: String, editStack: EditStack, upTo position: Int? = nil) {
+        imageCache.setImage(image,
+                            forKey: cacheKey(for: layerID, editStack: editStack, upTo: position ?? editStack.position),
+                            in: .renderGraph)
+    }
+
+    func removeCachedRenders() {
+        imageCache.removeObjects(in: .renderGraph, withKeyPrefix: cacheKeyPrefix)
+    }
+
+    func applyFilter(_ filter: FilterType,
+                     to image: CGImage,
+                     precision: PixelPrecisionType = .eight) async throws -> CGImage
+    {
+        if distortionFilterService.canApply(filter) {
+            return try await distortionFilterService.applyFilter(filter, to: image, precision: precision)
+        } else if cellFilterService.canApply(filter) {
+            return try await cellFilterService.applyFilter(filter, to: image, precision: precision)
+        } else if colorLookupTableService.canApply(filter) {
+            return try await colorLookupTableService.applyFilter(filter, to: image, precision: precision)
+        }
+
+        let workingPrecision = precision.deeper(than: PixelPrecisionType(cgImage: image))
+
+        return try await Task {
+            let ciImage = CIImage(cgImage: image)
+
+            let ciFilter = filter.createFilter(image: ciImage)
+
+            guard let outputImage = ciFilter.outputImage?.cropped(to: ciImage.extent) else {
+                throw PhotoExportError.unsupportedFilter
+            }
+
+            let context = CIContext()
+
+            let newExtent = ciImage.extent.insetBy(dx: -outputImage.extent.origin.x * 0.5,
+                                                   dy: -outputImage.extent.origin.y * 0.5)
+            guard let cgImage = context.createCGImage(outputImage,
+                                                      from: newExtent,
+                                                      format: workingPrecision.ciFormat,
+                                                      colorSpace: ColorManagementService.shared.workingColorSpace)
+            else { throw PhotoExportError.contextImageMaking }
+
+            return cgImage
+        }.value
+    }
+
+    private func cachedImage(for layerID: String, editStack: EditStack, upTo position: Int) -> CGImage? {
+        return imageCache.image(forKey: cacheKey(for: layerID, editStack: editStack, upTo: position), in: .renderGraph)
+    }
+
+    private func cacheKey(for layerID: String, editStack: EditStack, upTo position: Int) -> String {
+        return "\(cacheKeyPrefix)\(layerID)#\(editStack.signature(upTo: position))"
+    }
+}
@@ -0,0 +1,307 @@
+//
+//  GradientRasterizerService.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 18/07/2024.
+//
+
+import CoreGraphics
+import Foundation
+
+struct GradientRasterizerService {
+    enum Mode {
+        case linear
+        case radial
+        case angular
+    }
+
+    private static let fractionBits: Int32 = 16
+    private static let fixedPointOne = Float(1 << fractionBits)
+    private static let maxIndex = Int32(GradientLookupTable.entryCount - 1)
+
+    private static let ditherTileSize = 64
+    private static let ditherTile: [Float] = (0 ..< ditherTileSize * ditherTileSize).map { offset in
+        let x = Float(offset % ditherTileSize)
+        let y = Float(offset / ditherTileSize)
+        let phase = 0.06711056 * x + 0.00583715 * y
+        let noise = 52.9829189 * (phase - phase.rounded(.down))
+        return noise - noise.rounded(.down)
+    }
+
+    func fill(_ buffer: PixelBuffer,
+              lookupTable: GradientLookupTable,
+              mode: Mode = .linear,
+              start: CGPoint,
+              end: CGPoint,
+              isDithered: Bool = true)
+    {
+        let width = buffer.width
+        guard width > 0 else { return }
+
+        DispatchQueue.concurrentPerform(rowCount: buffer.height) { rows in
+            let indices = UnsafeMutablePointer<Int32>.allocate(capacity: width + 3)
+            let row = UnsafeMutablePointer<SIMD4<Float>>.allocate(capacity: width)
+            defer {
+                indices.deallocate()
+                row.deallocate()
+            }
+
+            for y in rows {
+                switch mode {
+                case .linear:
+                    linearIndices(row: y, width: width, start: start, end: end, into: indices)
+                case .radial:
+                    radialIndices(row: y, width: width, center: start, edge: end, into: indices)
+                case .angular:
+                    angularIndices(row: y, width: width, center: start, reference: end, into: indices)
+                }
+
+                writeRow(y, of: buffer, indices: indices, row: row, lookupTable: lookupTable, isDithered: isDithered)
+            }
+        }
+    }
+
+    func makeImage(_ gradient: CGLinearGradient,
+                   mode: Mode = .linear,
+                   size: CGSize,
+                   precision: PixelPrecisionType = .eight,
+                   isDithered: Bool = true) throws -> CGImage
+    {
+        let buffer = PixelBuffer(width: Int(size.width), height: Int(size.height), precision: precision)
+
+        fill(buffer,
+             lookupTable: gradient.lookupTable,
+             mode: mode,
+             start: CGPoint(x: size.width * gradient.startPoint.x, y: size.height * gradient.startPoint.y),
+             end: CGPoint(x: size.width * gradient.endPoint.x, y: size.height * gradient.endPoint.y),
+             isDithered: isDithered)
+
+        return try buffer.makeCGImage()
+    }
+
+    func drawGradient(_ gradient: CGLinearGradient,
+                      mode: Mode = .linear,
+                      start: CGPoint,
+                      end: CGPoint,
+                      in context: CGContext,
+                      isDithered: Bool = true) throws
+    {
+        let clipBounds = context.boundingBoxOfClipPath
+        guard !clipBounds.isNull, !clipBounds.isInfinite, !clipBounds.isEmpty else { return }
+
+        let transform = context.ctm
+        let scale = abs(transform.a * transform.d - transform.b * transform.c).squareRoot()
+        guard scale > 0.0 else { return }
+
+        let width = Int((clipBounds.width * scale).rounded(.up))
+        let height = Int((clipBounds.height * scale).rounded(.up))
+        guard width > 0, height > 0 else { return }
+
+        let drawRect = CGRect(origin: clipBounds.origin,
+                              size: CGSize(width: CGFloat(width) / scale, height: CGFloat(height) / scale))
+
+        let bufferPoint = { (point: CGPoint) in
+            CGPoint(x: (point.x - drawRect.minX) * scale, y: (drawRect.maxY - point.y) * scale)
+        }
+
+        // The gradient is rasterized at the destination's precision so deep projects do not band.
+        let buffer = PixelBuffer(width: width, height: height, precision: PixelPrecisionType(context: context))
+        fill(buffer,
+             lookupTable: gradient.lookupTable,
+             mode: mode,
+             start: bufferPoint(start),
+             end: bufferPoint(end),
+             isDithered: isDithered)
+
+        context.draw(try buffer.makeCGImage(), in: drawRect)
+    }
+
+    // Index along a row is affine in x, so it is stepped in 16.16 fixed point over the span where it
+    // stays inside the table and the spans before and after it are filled with the end entries.
+    private func linearIndices(row y: Int,
+                               width: Int,
+                               start: CGPoint,
+                               end: CGPoint,
+                               into indices: UnsafeMutablePointer<Int32>)
+    {
+        let directionX = Float(end.x - start.x)
+        let directionY = Float(end.y - start.y)
+        let lengthSquared = directionX * directionX + directionY * directionY
+        let maxIndex = Float(Self.maxIndex)
+
+        guard lengthSquared > .ulpOfOne else {
+            indices.update(repeating: Self.maxIndex, count: width)
+            return
+        }
+
+        let indexStep = directionX / lengthSquared * maxIndex
+        let rowIndex = ((0.5 - Float(start.x)) * directionX + (Float(y) + 0.5 - Float(start.y)) * directionY)
+            / lengthSquared * maxIndex
+
+        // Sub-pixel gradients step further than 16.16 can hold; they resolve in a pixel or two anyway.
+        guard abs(indexStep) * 4.0 * Self.fixedPointOne < Float(Int32.max) else {
+            for x in 0 ..< width {
+                indices[x] = Int32(min(max(rowIndex + indexStep * Float(x), 0.0), maxIndex))
+            }
+            return
+        }
+
+        var spanStart = 0
+        var spanEnd = width
+
+        if indexStep > 0.0 {
+            spanStart = Int(max(0.0, min(Float(width), ((0.0 - rowIndex) / indexStep).rounded(.up))))
+            spanEnd = Int(max(0.0, min(Float(width), ((maxIndex - rowIndex) / indexStep).rounded(.down) + 1.0)))
+        } else if indexStep < 0.0 {
+            spanStart = Int(max(0.0, min(Float(width), ((maxIndex - rowIndex) / indexStep).rounded(.up))))
+            spanEnd = Int(max(0.0, min(Float(width), ((0.0 - rowIndex) / indexStep).rounded(.down) + 1.0)))
+        } else if rowIndex < 0.0 || rowIndex > maxIndex {
+            spanStart = width
+        }
+        spanEnd = max(spanStart, spanEnd)
+
+        let leadingIndex: Int32 = indexStep < 0.0 || (indexStep == 0.0 && rowIndex > maxIndex) ? Self.maxIndex : 0
+        let trailingIndex: Int32 = indexStep < 0.0 ? 0 : Self.maxIndex
+
+        indices.update(repeating: leadingIndex, count: spanStart)
+        defer { (indices + spanEnd).update(repeating: trailingIndex, count: width - spanEnd) }
+
+        guard spanStart < spanEnd else { return }
+
+        let fixedStep = Int32((indexStep * Self.fixedPointOne).rounded())
+        var fixedIndex = SIMD4<Int32>(repeating: Int32(((rowIndex + indexStep * Float(spanStart))
+                * Self.fixedPointOne).rounded()))
+            &+ SIMD4<Int32>(0, 1, 2, 3) &* fixedStep
+        let fixedStride = SIMD4<Int32>(repeating: fixedStep &* 4)
+        let lowerBound = SIMD4<Int32>(repeating: 0)
+        let upperBound = SIMD4<Int32>(repeating: Self.maxIndex)
+
+        var x = spanStart
+        while x < spanEnd {
+            let index = (fixedIndex &>> Self.fractionBits).clamped(lowerBound: lowerBound, upperBound: upperBound)
+            UnsafeMutableRawPointer(indices + x).storeBytes(of: index, as: SIMD4<Int32>.self)
+            fixedIndex &+= fixedStride
+            x += 4
+        }
+    }
+
+    private func radialIndices(row y: Int,
+                               width: Int,
+                               center: CGPoint,
+                               edge: CGPoint,
+                               into indices: UnsafeMutablePointer<Int32>)
+    {
+        let radius = Float(hypot(edge.x - center.x, edge.y - center.y))
+        guard radius > .ulpOfOne else {
+            indices.update(repeating: Self.maxIndex, count: width)
+            return
+        }
+
+        let indexScale = Float(Self.maxIndex) / radius
+        let deltaY = Float(y) + 0.5 - Float(center.y)
+        let deltaYSquared = SIMD4<Float>(repeating: deltaY * deltaY)
+        let upperBound = SIMD4<Float>(repeating: Float(Self.maxIndex))
+
+        var deltaX = SIMD4<Float>(0.5, 1.5, 2.5, 3.5) - Float(center.x)
+        var x = 0
+        while x < width {
+            let distance = (deltaX * deltaX + deltaYSquared).squareRoot()
+            let index = (distance * indexScale).clamped(lowerBound: .zero, upperBound: upperBound)
+            UnsafeMutableRawPointer(indices + x).storeBytes(of: SIMD4<Int32>(index, rounding: .towardZero),
+                                                            as: SIMD4<Int32>.self)
+            deltaX += 4.0
+            x += 4
+        }
+    }
+
+    private func angularIndices(row y: Int,
+                                width: Int,
+                                center: CGPoint,
+                                reference: CGPoint,
+                                into indices: UnsafeMutablePointer<Int32>)
+    {
+        let referenceAngle = Float(atan2(reference.y - center.y, reference.x - center.x))
+        let indexScale = Float(Self.maxIndex) / (2.0 * .pi)
+        let deltaY = Float(y) + 0.5 - Float(center.y)
+
+        for x in 0 ..< width {
+            var angle = atan2(deltaY, Float(x) + 0.5 - Float(center.x)) - referenceAngle
+            if angle < 0.0 { angle += 2.0 * .pi }
+            indices[x] = min(Int32(angle * indexScale), Self.maxIndex)
+        }
+    }
+
+    // Dither noise spans one quantization step of the buffer, in the 0...255 range of the kernels.
+    // Half floats step finely enough around the stops not to band, so they are left undithered.
+    private static func ditherStep(for precision: PixelPrecisionType) -> Float {
+        switch precision {
+        case .eight:
+            1.0
+        case .sixteen:
+            255.0 / 65535.0
+        case .halfFloat:
+            0.0
+        }
+    }
+
+    private func writeRow(_ y: Int,
+                          of buffer: PixelBuffer,
+                          indices: UnsafeMutablePointer<Int32>,
+                          row: UnsafeMutablePointer<SIMD4<Float>>,
+                          lookupTable: GradientLookupTable,
+                          isDithered: Bool)
+    {
+        let ditherStep = isDithered ? Self.ditherStep(for: buffer.precision) : 0.0
+        let ditherRowOffset = (y % Self.ditherTileSize) * Self.ditherTileSize
+
+        lookupTable.colors.withUnsafeBufferPointer { colors in
+            guard ditherStep > 0.0 else {
+                for x in 0 ..< buffer.width {
+                    row[x] = colors[Int(indices[x])]
+                }
+                return
+            }
+
+            Self.ditherTile.withUnsafeBufferPointer { ditherTile in
+                for x in 0 ..< buffer.width {
+                    let noise = (ditherTile[ditherRowOffset + x % Self.ditherTileSize] - 0.5) * ditherStep
+                    row[x] = colors[Int(indices[x])] + noise
+                }
+            }
+        }
+
+        buffer.storeRow(y, from: row)
+    }
+}
+
+#if DEBUG
+extension GradientRasterizerService {
+    static func runBenchmark(sizes: [Int] = [512, 2048, 4096],
+                             precisions: [PixelPrecisionType] = PixelPrecisionType.allCases)
+    {
+        let service = GradientRasterizerService()
+        let lookupTable = GradientLookupTable(stops: [.init(color: .red, location: 0.0),
+                                                      .init(color: .green, location: 0.5),
+                                                      .init(color: .blue, location: 1.0)])
+
+        for size in sizes {
+            let start = CGPoint(x: 0.0, y: 0.0)
+            let end = CGPoint(x: size, y: size)
+
+            for precision in precisions {
+                let buffer = PixelBuffer(width: size, height: size, precision: precision)
+
+                for mode in [Mode.linear, .radial, .angular] {
+                    for isDithered in [false, true] {
+                        print("GradientRasterizer", size, precision.toString, mode, isDithered ? "dithered" : "plain")
+                        MeasureUtilities.functionTime {
+                            service.fill(buffer, lookupTable: lookupTable, mode: mode,
+                                         start: start, end: end, isDithered: isDithered)
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+#endif
@@ -0,0 +1,324 @@
+//
+//  ImageCacheService.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 26/07/2024.
+//
+
+import CoreGraphics
+import Foundation
+import UIKit
+
+final class ImageCacheService {
+    static let shared = ImageCacheService()
+
+    struct Metrics {
+        var hitCounts = [CacheTierType: Int]()
+        var missCounts = [CacheTierType: Int]()
+        var evictionCounts = [CacheTierType: Int]()
+        var pressureEvictionCounts = [CacheTierType: Int]()
+        var byteCosts = [CacheTierType: Int]()
+
+        var totalByteCost: Int {
+            return byteCosts.values.reduce(0, +)
+        }
+
+        func hitRate(of tier: CacheTierType) -> Double {
+            let hitCount = hitCounts[tier] ?? 0
+            return Double(hitCount) / Double(max(hitCount + (missCounts[tier] ?? 0), 1))
+        }
+    }
+
+    struct Lease {
+        let key: String
+        let tier: CacheTierType
+        fileprivate let entryID: UUID
+    }
+
+    private struct Entry {
+        let id = UUID()
+        let object: AnyObject
+        let cost: Int
+        var lastAccess: UInt64
+        var referenceCount = 1
+        var isPinned: Bool
+        let onEvict: (() -> Void)?
+    }
+
+    var byteBudget: Int {
+        get {
+            lock.lock()
+            defer { lock.unlock() }
+            return budget
+        }
+        set {
+            lock.lock()
+            budget = newValue
+            let evictedEntries = evictOverBudget()
+            lock.unlock()
+
+            evictedEntries.forEach { $0.onEvict?() }
+        }
+    }
+
+    private var budget: Int
+    private var entries = [CacheTierType: [String: Entry]]()
+    private var accessCounter: UInt64 = 0
+    private var metrics = Metrics()
+    private let lock = NSLock()
+
+    private var memoryPressureSource: DispatchSourceMemoryPressure?
+    private var memoryWarningObserver: NSObjectProtocol?
+
+    init(byteBudget: Int = Int(min(ProcessInfo.processInfo.physicalMemory / 4, 1024 * 1024 * 1024))) {
+        self.budget = byteBudget
+
+        let memoryPressureSource = DispatchSource.makeMemoryPressureSource(eventMask: [.warning, .critical],
+                                                                           queue: .global(qos: .utility))
+        memoryPressureSource.setEventHandler { [weak self, unowned memoryPressureSource] in
+            self?.handleMemoryPressure(isCritical: memoryPressureSource.data.contains(.critical))
+        }
+        memoryPressureSource.resume()
+        self.memoryPressureSource = memoryPressureSource
+
+        memoryWarningObserver = NotificationCenter.default.addObserver(
+            forName: UIApplication.didReceiveMemoryWarningNotification,
+            object: nil,
+            queue: nil)
+        { [weak self] _ in
+            self?.handleMemoryPressure(isCritical: true)
+        }
+    }
+
+    deinit {
+        memoryPressureSource?.cancel()
+        if let memoryWarningObserver {
+            NotificationCenter.default.removeObserver(memoryWarningObserver)
+        }
+    }
+
+    var currentMetrics: Metrics {
+        lock.lock()
+        defer { lock.unlock() }
+        return metrics
+    }
+
+    func object<T: AnyObject>(forKey key: String, in tier: CacheTierType) -> T? {
+        lock.lock()
+        defer { lock.unlock() }
+
+        guard let object = entries[tier]?[key]?.object as? T else {
+            metrics.missCounts[tier, default: 0] += 1
+            return nil
+        }
+
+        accessCounter += 1
+        entries[tier]?[key]?.lastAccess = accessCounter
+        metrics.hitCounts[tier, default: 0] += 1
+        return object
+    }
+
+    func image(forKey key: String, in tier: CacheTierType) -> CGImage? {
+        return object(forKey: key, in: tier)
+    }
+
+    func image(for lease: Lease) -> CGImage? {
+        lock.lock()
+        defer { lock.unlock() }
+
+        guard let entry = entries[lease.tier]?[lease.key], entry.id == lease.entryID else {
+            metrics.missCounts[lease.tier, default: 0] += 1
+            return nil
+        }
+
+        accessCounter += 1
+        entries[lease.tier]?[lease.key]?.lastAccess = accessCounter
+        metrics.hitCounts[lease.tier, default: 0] += 1
+        return (entry.object as! CGImage)
+    }
+
+    // `onEvict` lets owners that also hold the object strongly release it when the cache drops it.
+    func setObject(_ object: AnyObject,
+                   forKey key: String,
+                   in tier: CacheTierType,
+                   cost: Int,
+                   isPinned: Bool = false,
+                   onEvict: (() -> Void)? = nil)
+    {
+        lock.lock()
+        let evictedEntries = insert(Entry(object: object,
+                                          cost: cost,
+                                          lastAccess: 0,
+                                          isPinned: isPinned,
+                                          onEvict: onEvict),
+                                    forKey: key,
+                                    in: tier)
+        lock.unlock()
+
+        evictedEntries.forEach { $0.onEvict?() }
+    }
+
+    func setImage(_ image: CGImage,
+                  forKey key: String,
+                  in tier: CacheTierType,
+                  isPinned: Bool = false,
+                  onEvict: (() -> Void)? = nil)
+    {
+        setObject(image, forKey: key, in: tier, cost: image.byteCost, isPinned: isPinned, onEvict: onEvict)
+    }
+
+    // Holders of the same bitmap share one reference-counted entry, so it is costed only once.
+    func retainImage(_ image: CGImage, forKey key: String, in tier: CacheTierType) -> Lease {
+        lock.lock()
+        if let entry = entries[tier]?[key], entry.object === image {
+            accessCounter += 1
+            entries[tier]?[key]?.referenceCount += 1
+            entries[tier]?[key]?.lastAccess = accessCounter
+            lock.unlock()
+
+            return Lease(key: key, tier: tier, entryID: entry.id)
+        }
+
+        let entry = Entry(object: image, cost: image.byteCost, lastAccess: 0, isPinned: false, onEvict: nil)
+        let evictedEntries = insert(entry, forKey: key, in: tier)
+        lock.unlock()
+
+        evictedEntries.forEach { $0.onEvict?() }
+        return Lease(key: key, tier: tier, entryID: entry.id)
+    }
+
+    // Releasing a lease whose entry was already evicted or replaced is a no-op.
+    func release(_ lease: Lease) {
+        lock.lock()
+        if let entry = entries[lease.tier]?[lease.key], entry.id == lease.entryID {
+            if entry.referenceCount > 1 {
+                entries[lease.tier]?[lease.key]?.referenceCount -= 1
+            } else {
+                entries[lease.tier]?[lease.key] = nil
+                metrics.byteCosts[lease.tier, default: 0] -= entry.cost
+            }
+        }
+        lock.unlock()
+    }
+
+    // Pinned entries count against the budget but are never evicted.
+    func setPinned(_ isPinned: Bool, forKey key: String, in tier: CacheTierType) {
+        lock.lock()
+        entries[tier]?[key]?.isPinned = isPinned
+        let evictedEntries = isPinned ? [] : evictOverBudget()
+        lock.unlock()
+
+        evictedEntries.forEach { $0.onEvict?() }
+    }
+
+    func removeObject(forKey key: String, in tier: CacheTierType) {
+        lock.lock()
+        if let removedEntry = entries[tier]?.removeValue(forKey: key) {
+            metrics.byteCosts[tier, default: 0] -= removedEntry.cost
+        }
+        lock.unlock()
+    }
+
+    func removeObjects(in tier: CacheTierType, withKeyPrefix keyPrefix: String = "") {
+        lock.lock()
+        let removedKeys = entries[tier]?.keys.filter { $0.hasPrefix(keyPrefix) } ?? []
+        for key in removedKeys {
+            if let removedEntry = entries[tier]?.removeValue(forKey: key) {
+                metrics.byteCosts[tier, default: 0] -= removedEntry.cost
+            }
+        }
+        lock.unlock()
+    }
+
+    // A warning drops what is cheapest to rebuild; a critical event drops every regenerable tier.
+    private func handleMemoryPressure(isCritical: Bool) {
+        let tiers = CacheTierType.allCases.filter { tier in
+            isCritical ? tier.isRegenerable : tier < .thumbnail
+        }
+
+        lock.lock()
+        var evictedEntries = [Entry]()
+        for tier in tiers {
+            guard let tierEntries = entries[tier] else { continue }
+
+            for (key, entry) in tierEntries where !entry.isPinned {
+                entries[tier]?[key] = nil
+                metrics.byteCosts[tier, default: 0] -= entry.cost
+                metrics.pressureEvictionCounts[tier, default: 0] += 1
+                evictedEntries.append(entry)
+            }
+        }
+        lock.unlock()
+
+        evictedEntries.forEach { $0.onEvict?() }
+
+        #if DEBUG
+        print("Image cache: memory pressure (\(isCritical ? "critical" : "warning")), dropped \(evictedEntries.count) entries")
+        #endif
+    }
+
+    // Must be called with the lock held.
+    private func insert(_ entry: Entry, forKey key: String, in tier: CacheTierType) -> [Entry] {
+        if let replacedEntry = entries[tier]?[key] {
+            metrics.byteCosts[tier, default: 0] -= replacedEntry.cost
+        }
+
+        var entry = entry
+        accessCounter += 1
+        entry.lastAccess = accessCounter
+        entries[tier, default: [:]][key] = entry
+        metrics.byteCosts[tier, default: 0] += entry.cost
+
+        return evictOverBudget(sparing: (tier, key))
+    }
+
+    // LRU within a tier, lower tiers first. Must be called with the lock held.
+    private func evictOverBudget(sparing sparedEntry: (tier: CacheTierType, key: String)? = nil) -> [Entry] {
+        var evictedEntries = [Entry]()
+
+        while metrics.totalByteCost > budget {
+            var victim: (tier: CacheTierType, key: String, lastAccess: UInt64)?
+
+            for tier in CacheTierType.allCases {
+                for (key, entry) in entries[tier] ?? [:] where !entry.isPinned {
+                    guard sparedEntry?.tier != tier || sparedEntry?.key != key else { continue }
+
+                    if entry.lastAccess < victim?.lastAccess ?? .max {
+                        victim = (tier, key, entry.lastAccess)
+                    }
+                }
+                if victim != nil { break }
+            }
+
+            guard let victim,
+                  let evictedEntry = entries[victim.tier]?.removeValue(forKey: victim.key)
+            else { break }
+
+            metrics.byteCosts[victim.tier, default: 0] -= evictedEntry.cost
+            metrics.evictionCounts[victim.tier, default: 0] += 1
+            evictedEntries.append(evictedEntry)
+        }
+
+        return evictedEntries
+    }
+}
+
+#if DEBUG
+extension ImageCacheService {
+    func printMetrics() {
+        let metrics = currentMetrics
+
+        print("Image cache: \(metrics.totalByteCost / 1024 / 1024) MB of \(byteBudget / 1024 / 1024) MB")
+        for tier in CacheTierType.allCases {
+            print("""
+            \(tier): \((metrics.byteCosts[tier] ?? 0) / 1024 / 1024) MB, \
+            hits \(metrics.hitCounts[tier] ?? 0), \
+            misses \(metrics.missCounts[tier] ?? 0) \
+            (\(String(format: "%.0f", metrics.hitRate(of: tier) * 100.0))%), \
+            evictions \(metrics.evictionCounts[tier] ?? 0), \
+            pressure evictions \(metrics.pressureEvictionCounts[tier] ?? 0)
+            """)
+        }
+    }
+}
+#endif
@@ -0,0 +1,314 @@
+//
+//  LayerCompositorService.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 19/07/2024.
+//
+
+import CoreGraphics
+import Foundation
+
+struct LayerCompositorService {
+    struct CompositeLayer {
+        let image: CGImage
+        let transform: CGAffineTransform
+        let blendMode: BlendModeType
+        var opacity: Float = 1.0
+    }
+
+    func composite(layers: [CompositeLayer],
+                   pixelSize: CGSize,
+                   backgroundColor: CGColor,
+                   precision: PixelPrecisionType = .eight) throws -> CGImage
+    {
+        let width = Int(pixelSize.width)
+        let height = Int(pixelSize.height)
+
+        let output = try CompositeBuffer(width: width, height: height, precision: precision)
+        let sources = try layers.map { try CompositeBuffer(cgImage: $0.image, precision: precision) }
+        let inverseTransforms = layers.map { $0.transform.inverted() }
+        let deviceBounds = layers.map {
+            CGRect(x: 0, y: 0, width: $0.image.width, height: $0.image.height).applying($0.transform)
+        }
+        let background = premultipliedComponents(of: backgroundColor)
+
+        DispatchQueue.concurrentPerform(rowCount: height) { rows in
+            let accumulator = UnsafeMutablePointer<SIMD4<Float>>.allocate(capacity: width)
+            defer { accumulator.deallocate() }
+
+            for row in rows {
+                accumulator.initialize(repeating: background, count: width)
+                let deviceY = CGFloat(height - row) - 0.5
+
+                for (index, layer) in layers.enumerated() where layer.opacity > 0.0 {
+                    let bounds = deviceBounds[index]
+                    guard deviceY >= bounds.minY, deviceY <= bounds.maxY else { continue }
+
+                    let startX = max(0, Int(bounds.minX.rounded(.down)))
+                    let endX = min(width, Int(bounds.maxX.rounded(.up)))
+                    guard startX < endX else { continue }
+
+                    let inverseTransform = inverseTransforms[index]
+                    let source = sources[index]
+                    let layerPoint = CGPoint(x: CGFloat(startX) + 0.5, y: deviceY).applying(inverseTransform)
+
+                    blendRow(accumulator,
+                             columns: startX ..< endX,
+                             source: source,
+                             origin: SIMD2(Float(layerPoint.x) - 0.5, Float(source.height) - Float(layerPoint.y) - 0.5),
+                             step: SIMD2(Float(inverseTransform.a), -Float(inverseTransform.b)),
+                             blendMode: layer.blendMode,
+                             opacity: min(layer.opacity, 1.0))
+                }
+
+                output.store(row: row, from: accumulator)
+            }
+        }
+
+        return try output.makeCGImage()
+    }
+
+    private func blendRow(_ accumulator: UnsafeMutablePointer<SIMD4<Float>>,
+                          columns: Range<Int>,
+                          source: CompositeBuffer,
+                          origin: SIMD2<Float>,
+                          step: SIMD2<Float>,
+                          blendMode: BlendModeType,
+                          opacity: Float)
+    {
+        switch blendMode {
+        case .normal:
+            forEachSample(accumulator, columns, source, origin, step, opacity, BlendKernel.normal)
+        case .multiply:
+            forEachSample(accumulator, columns, source, origin, step, opacity, BlendKernel.multiply)
+        case .screen:
+            forEachSample(accumulator, columns, source, origin, step, opacity, BlendKernel.screen)
+        case .overlay:
+            forEachSample(accumulator, columns, source, origin, step, opacity, BlendKernel.overlay)
+        case .softLight:
+            forEachSample(accumulator, columns, source, origin, step, opacity, BlendKernel.softLight)
+        case .darken:
+            forEachSample(accumulator, columns, source, origin, step, opacity, BlendKernel.darken)
+        case .lighten:
+            forEachSample(accumulator, columns, source, origin, step, opacity, BlendKernel.lighten)
+        case .difference:
+            forEachSample(accumulator, columns, source, origin, step, opacity, BlendKernel.difference)
+        case .destinationOut:
+            forEachSample(accumulator, columns, source, origin, step, opacity, BlendKernel.destinationOut)
+        }
+    }
+
+    // Every kernel leaves the destination untouched for a fully transparent source,
+    // so samples outside the layer are skipped without blending. Layer opacity scales
+    // the premultiplied sample, which keeps opacity edits free of any pixel re-bake.
+    @inline(__always)
+    private func forEachSample(_ accumulator: UnsafeMutablePointer<SIMD4<Float>>,
+                               _ columns: Range<Int>,
+                               _ source: CompositeBuffer,
+                               _ origin: SIMD2<Float>,
+                               _ step: SIMD2<Float>,
+                               _ opacity: Float,
+                               _ kernel: (SIMD4<Float>, SIMD4<Float>) -> SIMD4<Float>)
+    {
+        var position = origin
+        for x in columns {
+            let sample = source.bilinearSample(position) * opacity
+            if sample.w > 0.0 {
+                accumulator[x] = kernel(sample, accumulator[x])
+            }
+            position += step
+        }
+    }
+
+    private func premultipliedComponents(of color: CGColor) -> SIMD4<Float> {
+        guard let components = color.converted(to: ColorManagementService.shared.workingColorSpace,
+                                               intent: .defaultIntent,
+                                               options: nil)?.components,
+            components.count == 4
+        else { return .zero }
+
+        let alpha = Float(components[3])
+        return SIMD4(Float(components[0]) * alpha, Float(components[1]) * alpha, Float(components[2]) * alpha, alpha)
+    }
+}
+
+extension LayerCompositorService {
+    // Premultiplied source (s) over premultiplied destination (d), all channels in 0...1.
+    enum BlendKernel {
+        @inline(__always)
+        static func normal(_ s: SIMD4<Float>, _ d: SIMD4<Float>) -> SIMD4<Float> {
+            return s + d * (1.0 - s.w)
+        }
+
+        @inline(__always)
+        static func multiply(_ s: SIMD4<Float>, _ d: SIMD4<Float>) -> SIMD4<Float> {
+            return s * d + s * (1.0 - d.w) + d * (1.0 - s.w)
+        }
+
+        @inline(__always)
+        static func screen(_ s: SIMD4<Float>, _ d: SIMD4<Float>) -> SIMD4<Float> {
+            return s + d - s * d
+        }
+
+        @inline(__always)
+        static func overlay(_ s: SIMD4<Float>, _ d: SIMD4<Float>) -> SIMD4<Float> {
+            let sourceAlpha = SIMD4(repeating: s.w)
+            let destinationAlpha = SIMD4(repeating: d.w)
+
+            let multiplied = 2.0 * s * d
+            let screened = sourceAlpha * destinationAlpha - 2.0 * (destinationAlpha - d) * (sourceAlpha - s)
+            let blended = screened.replacing(with: multiplied, where: 2.0 * d .<= destinationAlpha)
+
+            return withUnionAlpha(blended + s * (1.0 - d.w) + d * (1.0 - s.w), s, d)
+        }
+
+        @inline(__always)
+        static func softLight(_ s: SIMD4<Float>, _ d: SIMD4<Float>) -> SIMD4<Float> {
+            let source = s / s.w
+            let destination = d.w > 0.0 ? d / d.w : .zero
+
+            let darkened = destination - (1.0 - 2.0 * source) * destination * (1.0 - destination)
+            let dodge = ((16.0 * destination - 12.0) * destination + 4.0) * destination
+            let root = dodge.replacing(with: destination.squareRoot(), where: destination .> 0.25)
+            let lightened = destination + (2.0 * source - 1.0) * (root - destination)
+            let blended = lightened.replacing(with: darkened, where: source .<= 0.5)
+
+            return withUnionAlpha(s * (1.0 - d.w) + d * (1.0 - s.w) + blended * (s.w * d.w), s, d)
+        }
+
+        @inline(__always)
+        static func darken(_ s: SIMD4<Float>, _ d: SIMD4<Float>) -> SIMD4<Float> {
+            return pointwiseMin(s * d.w, d * s.w) + s * (1.0 - d.w) + d * (1.0 - s.w)
+        }
+
+        @inline(__always)
+        static func lighten(_ s: SIMD4<Float>, _ d: SIMD4<Float>) -> SIMD4<Float> {
+            return pointwiseMax(s * d.w, d * s.w) + s * (1.0 - d.w) + d * (1.0 - s.w)
+        }
+
+        @inline(__always)
+        static func difference(_ s: SIMD4<Float>, _ d: SIMD4<Float>) -> SIMD4<Float> {
+            return withUnionAlpha(s + d - 2.0 * pointwiseMin(s * d.w, d * s.w), s, d)
+        }
+
+        @inline(__always)
+        static func destinationOut(_ s: SIMD4<Float>, _ d: SIMD4<Float>) -> SIMD4<Float> {
+            return d * (1.0 - s.w)
+        }
+
+        @inline(__always)
+        private static func withUnionAlpha(_ color: SIMD4<Float>,
+                                           _ s: SIMD4<Float>,
+                                           _ d: SIMD4<Float>) -> SIMD4<Float>
+        {
+            var color = color
+            color.w = s.w + d.w - s.w * d.w
+            return color
+        }
+    }
+}
+
+private final class CompositeBuffer {
+    let width: Int
+    let height: Int
+    let precision: PixelPrecisionType
+    let bytesPerRow: Int
+    let data: UnsafeMutableRawPointer
+
+    init(width: Int, height: Int, precision: PixelPrecisionType) throws {
+        guard width > 0, height > 0 else {
+            throw PhotoExportError.contextCreation(contextSize: CGSize(width: width, height: height))
+        }
+
+        self.width = width
+        self.height = height
+        self.precision = precision
+        self.bytesPerRow = width * precision.bytesPerPixel
+        self.data = UnsafeMutableRawPointer.allocate(byteCount: bytesPerRow * height, alignment: 16)
+        self.data.initializeMemory(as: UInt8.self, repeating: 0, count: bytesPerRow * height)
+    }
+
+    convenience init(cgImage: CGImage, precision: PixelPrecisionType) throws {
+        try self.init(width: cgImage.width, height: cgImage.height, precision: precision)
+
+        let context = try createContext()
+        context.draw(cgImage, in: CGRect(x: 0, y: 0, width: width, height: height))
+    }
+
+    deinit {
+        data.deallocate()
+    }
+
+    func createContext() throws -> CGContext {
+        guard let context = precision.createContext(width: width, height: height, data: data) else {
+            throw PhotoExportError.contextCreation(contextSize: CGSize(width: width, height: height))
+        }
+        return context
+    }
+
+    func makeCGImage() throws -> CGImage {
+        guard let cgImage = try createContext().makeImage() else {
+            throw PhotoExportError.contextImageMaking
+        }
+        return cgImage
+    }
+
+    @inline(__always)
+    func texel(x: Int, y: Int) -> SIMD4<Float> {
+        guard x >= 0, y >= 0, x < width, y < height else { return .zero }
+
+        switch precision {
+        case .eight:
+            let rawTexel = data.load(fromByteOffset: y * bytesPerRow + x * 4, as: SIMD4<UInt8>.self)
+            return SIMD4<Float>(rawTexel) * (1.0 / 255.0)
+        case .sixteen:
+            let rawTexel = data.load(fromByteOffset: y * bytesPerRow + x * 8, as: SIMD4<UInt16>.self)
+            return SIMD4<Float>(rawTexel) * (1.0 / 65535.0)
+        case .halfFloat:
+            return SIMD4<Float>(data.load(fromByteOffset: y * bytesPerRow + x * 8, as: SIMD4<Float16>.self))
+        }
+    }
+
+    // Texels outside the image read as transparent, which antialiases the layer edges.
+    @inline(__always)
+    func bilinearSample(_ position: SIMD2<Float>) -> SIMD4<Float> {
+        guard position.x > -1.0, position.y > -1.0,
+              position.x < Float(width), position.y < Float(height)
+        else { return .zero }
+
+        let floored = position.rounded(.down)
+        let x0 = Int(floored.x)
+        let y0 = Int(floored.y)
+        let fraction = position - floored
+
+        let top = texel(x: x0, y: y0) + (texel(x: x0 + 1, y: y0) - texel(x: x0, y: y0)) * fraction.x
+        let bottom = texel(x: x0, y: y0 + 1) + (texel(x: x0 + 1, y: y0 + 1) - texel(x: x0, y: y0 + 1)) * fraction.x
+
+        return top + (bottom - top) * fraction.y
+    }
+
+    func store(row: Int, from accumulator: UnsafeMutablePointer<SIMD4<Float>>) {
+        let rowStart = data + row * bytesPerRow
+
+        switch precision {
+        case .eight:
+            let pixels = rowStart.assumingMemoryBound(to: SIMD4<UInt8>.self)
+            for x in 0 ..< width {
+                let value = (accumulator[x] * 255.0 + 0.5).clamped(lowerBound: .zero, upperBound: SIMD4(repeating: 255.0))
+                pixels[x] = SIMD4<UInt8>(value)
+            }
+        case .sixteen:
+            let pixels = rowStart.assumingMemoryBound(to: SIMD4<UInt16>.self)
+            for x in 0 ..< width {
+                let value = (accumulator[x] * 65535.0 + 0.5).clamped(lowerBound: .zero,
+                                                                     upperBound: SIMD4(repeating: 65535.0))
+                pixels[x] = SIMD4<UInt16>(value)
+            }
+        case .halfFloat:
+            let pixels = rowStart.assumingMemoryBound(to: SIMD4<Float16>.self)
+            for x in 0 ..< width {
+                pixels[x] = SIMD4<Float16>(accumulator[x].clamped(lowerBound: .zero, upperBound: SIMD4(repeating: 1.0)))
+            }
+        }
+    }
+}
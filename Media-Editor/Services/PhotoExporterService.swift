@@ -9,6 +9,11 @@ import Foundation
 import SwiftUI
 
 struct PhotoExporterService {
+    private let cropMaskRasterizerService = CropMaskRasterizerService()
+    private let textRenderCacheService = TextRenderCacheService()
+    private let gradientRasterizerService = GradientRasterizerService()
+    private let layerCompositorService = LayerCompositorService()
+
     func resizePhoto(renderedPhoto: CGImage,
                      renderSize: RenderSizeType,
                      photoFormat: PhotoFormatType,
@@ -35,7 +40,7 @@ struct PhotoExporterService {
                                           height: Int(resizedFramePixelHeight),
                                           bitsPerComponent: 8,
                                           bytesPerRow: 0,
-                                          space: CGColorSpaceCreateDeviceRGB(),
+                                          space: ColorManagementService.shared.workingColorSpace,
                                           bitmapInfo: CGImageAlphaInfo.premultipliedLast.rawValue)
             else {
                 throw PhotoExportError.contextCreation(contextSize: .init(width: CGFloat(resizedFramePixelWidth),
@@ -65,7 +70,7 @@ struct PhotoExporterService {
                                       height: resizedHeight,
                                       bitsPerComponent: 8,
                                       bytesPerRow: 0,
-                                      space: CGColorSpaceCreateDeviceRGB(),
+                                      space: ColorManagementService.shared.workingColorSpace,
                                       bitmapInfo: CGImageAlphaInfo.premultipliedFirst.rawValue)
         else {
             throw PhotoExportError.contextCreation(contextSize: .init(width: CGFloat(resizedWidth),
@@ -115,15 +120,7 @@ struct PhotoExporterService {
                     - max(0.0, offsetSize.height)
             )
 
-            guard let context = CGContext(data: nil,
-                                          width: Int(contextSize.width),
-                                          height: Int(contextSize.height),
-                                          bitsPerComponent: 8,
-                                          bytesPerRow: 0,
-                                          space: CGColorSpaceCreateDeviceRGB(),
-                                          bitmapInfo: CGImageAlphaInfo.premultipliedFirst.rawValue)
-
-            else { throw PhotoExportError.contextCreation(contextSize: .init(width: Int(contextSize.width), height: Int(contextSize.height))) }
+            let context = try createContext(size: contextSize, precision: PixelPrecisionType(cgImage: layerImage))
 
             let bezierPath = UIBezierPath(cgPath: cropPath.cgPath)
 
@@ -169,10 +166,6 @@ struct PhotoExporterService {
                     .concatenating(shapeCoverageTranslation)
             )
 
-            context.addPath(bezierPath.cgPath)
-
-            context.clip()
-
             context.concatenate(croppingFrameCoverageTranslation)
             context.concatenate(shapeCoverageTranslation)
 
@@ -192,10 +185,25 @@ struct PhotoExporterService {
 
             context.scaleBy(x: copysign(-1.0, layer.scaleX ?? 1.0), y: copysign(-1.0, layer.scaleY ?? 1.0))
 
-            context.draw(layerImage, in: CGRect(x: 0,
-                                                y: 0,
-                                                width: CGFloat(layerImage.width),
-                                                height: CGFloat(layerImage.height)))
+            let destinationBounds = bezierPath.cgPath.boundingBoxOfPath
+                .intersection(CGRect(origin: .zero, size: CGSize(width: context.width, height: context.height)))
+            let layerImageRect = CGRect(x: 0, y: 0, width: CGFloat(layerImage.width), height: CGFloat(layerImage.height))
+            let sourceRect = destinationBounds
+                .applying(context.userSpaceToDeviceSpaceTransform.inverted())
+                .insetBy(dx: -1.0, dy: -1.0)
+                .integral
+                .intersection(layerImageRect)
+
+            if !sourceRect.isNull, !sourceRect.isEmpty,
+               let sourceImage = layerImage.cropping(to: CGRect(x: sourceRect.minX,
+                                                                y: layerImageRect.height - sourceRect.maxY,
+                                                                width: sourceRect.width,
+                                                                height: sourceRect.height))
+            {
+                context.draw(sourceImage, in: sourceRect)
+            }
+
+            try cropMaskRasterizerService.applyMask(path: bezierPath.cgPath, to: context)
 
             let clippedImage = context.makeImage()
 
@@ -211,70 +219,65 @@ struct PhotoExporterService {
                              offsetFromCenter: CGPoint = .zero,
                              projectBackgroundColor: CGColor = Color.clear.cgColor,
                              layerBackgroundShapeStyle: ShapeStyleModel? = nil,
-                             isApplyingTransforms: Bool = true) async throws -> CGImage
+                             isApplyingTransforms: Bool = true,
+                             isUsingOriginals: Bool = false,
+                             precision: PixelPrecisionType = .eight,
+                             renderScale: CGFloat = 1.0) async throws -> CGImage
     {
         return try await Task {
-            guard let context = CGContext(data: nil,
-                                          width: Int(contextPixelSize.width),
-                                          height: Int(contextPixelSize.height),
-                                          bitsPerComponent: 8,
-                                          bytesPerRow: 0,
-                                          space: CGColorSpaceCreateDeviceRGB(),
-                                          bitmapInfo: CGImageAlphaInfo.premultipliedFirst.rawValue)
-            else { throw PhotoExportError
-                .contextCreation(contextSize:
-                    .init(width: Int(contextPixelSize.width),
-                          height: Int(contextPixelSize.height)))
+            let renderScaleTransform = CGAffineTransform(scaleX: renderScale, y: renderScale)
+            let renderPixelSize = contextPixelSize.applying(renderScaleTransform)
+
+            let sortedPhotos = photos
+                .filter { $0.positionZ != nil && $0.positionZ! > 0 }
+                .sorted { $0.positionZ! < $1.positionZ! }
+
+            let workingPrecision = sortedPhotos
+                .compactMap { $0.cgImage.map(PixelPrecisionType.init(cgImage:)) }
+                .reduce(precision) { $0.deeper(than: $1) }
+
+            if isApplyingTransforms, layerBackgroundShapeStyle == nil {
+                let compositeLayers = sortedPhotos.compactMap { photo -> LayerCompositorService.CompositeLayer? in
+                    guard let (layerImage, imageTransform) = exportedImage(of: photo, isUsingOriginal: isUsingOriginals),
+                          let transform = layerTransform(of: photo,
+                                                         contextPixelSize: contextPixelSize,
+                                                         offsetFromCenter: offsetFromCenter)
+                    else { return nil }
+
+                    return .init(image: layerImage,
+                                 transform: imageTransform
+                                     .concatenating(transform)
+                                     .concatenating(renderScaleTransform),
+                                 blendMode: photo.blendMode,
+                                 opacity: Float(photo.opacity))
+                }
+
+                return try layerCompositorService.composite(
+                    layers: compositeLayers,
+                    pixelSize: renderPixelSize,
+                    backgroundColor: projectBackgroundColor,
+                    precision: workingPrecision)
             }
 
+            let context = try createContext(size: renderPixelSize, precision: workingPrecision)
+
+            context.concatenate(renderScaleTransform)
             context.setFillColor(projectBackgroundColor)
 
             context.fill(CGRect(origin: .zero, size: contextPixelSize))
 
-            for photo in photos
-                .filter({ $0.positionZ != nil && $0.positionZ! > 0 })
-                .sorted(by: { $0.positionZ! < $1.positionZ! })
-            {
-                guard let scaleX = photo.scaleX,
-                      let scaleY = photo.scaleY,
-                      let rotation = photo.rotation,
-                      let position = photo.position
+            for photo in sortedPhotos {
+                guard let resultTransform = layerTransform(of: photo,
+                                                           contextPixelSize: contextPixelSize,
+                                                           offsetFromCenter: offsetFromCenter)
                 else { continue }
 
-                guard let layerImage = photo.cgImage else { continue }
+                guard let (layerImage, _) = exportedImage(of: photo, isUsingOriginal: isUsingOriginals) else { continue }
 
                 context.saveGState()
-
-                let centerTranslation =
-                    CGSize(width: photo.pixelSize.width * 0.5,
-                           height: photo.pixelSize.height * 0.5)
-
-                let translationTransform = CGAffineTransform(
-                    translationX: contextPixelSize.width * 0.5
-                        - centerTranslation.width * scaleX
-                        + position.x * photo.pixelToDigitalWidthRatio + offsetFromCenter.x,
-                    y:
-                    contextPixelSize.height * 0.5
-                        - centerTranslation.height * scaleY
-                        - position.y * photo.pixelToDigitalHeightRatio - offsetFromCenter.y
-                )
-
-                let scaleTransform = CGAffineTransform(scaleX: scaleX, y: scaleY)
-                let rotationTransform = CGAffineTransform(rotationAngle: -rotation.radians)
-
-                let originTranslation = CGAffineTransform(translationX: -centerTranslation.width * scaleX,
-                                                          y: -centerTranslation.height * scaleY)
-                let reverseOriginTranslation = CGAffineTransform(translationX: centerTranslation.width * scaleX,
-                                                                 y: +centerTranslation.height * scaleY)
-
-                let resultTransform = CGAffineTransform.identity
-                    .concatenating(scaleTransform)
-                    .concatenating(originTranslation)
-                    .concatenating(rotationTransform)
-                    .concatenating(reverseOriginTranslation)
-                    .concatenating(translationTransform)
-
+                // Baking a single layer keeps its opacity out of the pixels; it is applied on display.
                 if isApplyingTransforms {
+                    context.setAlpha(CGFloat(photo.opacity))
                     context.concatenate(resultTransform)
                 }
 
@@ -284,9 +287,7 @@ struct PhotoExporterService {
                 if layerBackgroundShapeStyle != nil {
                     if let color = shapeStyle as? Color {
                         context.setFillColor(color.cgColor)
-                    } else if let cgLinearGradient = shapeStyleCG as? CGLinearGradient,
-                              let cgGradient = cgLinearGradient.cgGradient
-                    {
+                    } else if let cgLinearGradient = shapeStyleCG as? CGLinearGradient {
                         let startPoint = cgLinearGradient.startPoint
                         let endPoint = cgLinearGradient.endPoint
 
@@ -298,10 +299,10 @@ struct PhotoExporterService {
                         let start = CGPoint(x: startX, y: startY)
                         let end = CGPoint(x: endX, y: endY)
 
-                        context.drawLinearGradient(cgGradient,
-                                                   start: start,
-                                                   end: end,
-                                                   options: [.drawsAfterEndLocation, .drawsBeforeStartLocation])
+                        try gradientRasterizerService.drawGradient(cgLinearGradient,
+                                                                   start: start,
+                                                                   end: end,
+                                                                   in: context)
                     }
                     context.fill(CGRect(origin: .zero, size: .init(width: photo.pixelSize.width,
                                                                    height: photo.pixelSize.height)))
@@ -322,6 +323,80 @@ struct PhotoExporterService {
         }.value
     }
 
+    // 8-bit output keeps the established ARGB layout, deeper precisions use the RGBA working formats.
+    private func createContext(size: CGSize, precision: PixelPrecisionType) throws -> CGContext {
+        let width = Int(size.width)
+        let height = Int(size.height)
+
+        let context = precision == .eight
+            ? CGContext(data: nil,
+                        width: width,
+                        height: height,
+                        bitsPerComponent: 8,
+                        bytesPerRow: 0,
+                        space: ColorManagementService.shared.workingColorSpace,
+                        bitmapInfo: CGImageAlphaInfo.premultipliedFirst.rawValue)
+            : precision.createContext(width: width, height: height)
+
+        guard let context else {
+            throw PhotoExportError.contextCreation(contextSize: .init(width: width, height: height))
+        }
+        return context
+    }
+
+    // Originals are drawn into the proxy's pixel rect, so the layer geometry stays unchanged.
+    private func exportedImage(of photo: LayerModel,
+                               isUsingOriginal: Bool) -> (image: CGImage, transform: CGAffineTransform)?
+    {
+        guard let layerImage = photo.cgImage else { return nil }
+        guard isUsingOriginal, photo.isShowingImportProxy,
+              let originalImage = photo.originalCGImage(), originalImage !== layerImage
+        else { return (layerImage, .identity) }
+
+        return (originalImage, CGAffineTransform(scaleX: CGFloat(layerImage.width) / CGFloat(originalImage.width),
+                                                 y: CGFloat(layerImage.height) / CGFloat(originalImage.height)))
+    }
+
+    private func layerTransform(of photo: LayerModel,
+                                contextPixelSize: CGSize,
+                                offsetFromCenter: CGPoint) -> CGAffineTransform?
+    {
+        guard let scaleX = photo.scaleX,
+              let scaleY = photo.scaleY,
+              let rotation = photo.rotation,
+              let position = photo.position
+        else { return nil }
+
+        let centerTranslation =
+            CGSize(width: photo.pixelSize.width * 0.5,
+                   height: photo.pixelSize.height * 0.5)
+
+        let translationTransform = CGAffineTransform(
+            translationX: contextPixelSize.width * 0.5
+                - centerTranslation.width * scaleX
+                + position.x * photo.pixelToDigitalWidthRatio + offsetFromCenter.x,
+            y:
+            contextPixelSize.height * 0.5
+                - centerTranslation.height * scaleY
+                - position.y * photo.pixelToDigitalHeightRatio - offsetFromCenter.y
+        )
+
+        let scaleTransform = CGAffineTransform(scaleX: scaleX, y: scaleY)
+        let rotationTransform = CGAffineTransform(rotationAngle: -rotation.radians)
+
+        let originTranslation = CGAffineTransform(translationX: -centerTranslation.width * scaleX,
+                                                  y: -centerTranslation.height * scaleY)
+        let reverseOriginTranslation = CGAffineTransform(translationX: centerTranslation.width * scaleX,
+                                                         y: +centerTranslation.height * scaleY)
+
+        return CGAffineTransform.identity
+            .concatenating(scaleTransform)
+            .concatenating(originTranslation)
+            .concatenating(rotationTransform)
+            .concatenating(reverseOriginTranslation)
+            .concatenating(translationTransform)
+    }
+
     func renderImageFromDrawings(
         from drawings: [DrawingModel],
         on layer: LayerModel,
@@ -329,18 +404,10 @@ struct PhotoExporterService {
         pixelFrameSize: CGSize
     ) async throws -> CGImage {
         return try await Task {
-            guard let context = CGContext(data: nil,
-                                          width: Int(pixelFrameSize.width),
-                                          height: Int(pixelFrameSize.height),
-                                          bitsPerComponent: 8,
-                                          bytesPerRow: 0,
-                                          space: CGColorSpaceCreateDeviceRGB(),
-                                          bitmapInfo: CGImageAlphaInfo.premultipliedFirst.rawValue)
-
-            else { throw PhotoExportError.contextCreation(contextSize: .init(width: Int(pixelFrameSize.width), height: Int(pixelFrameSize.height))) }
-
             guard let layerImage = layer.cgImage, let layerScaleX = layer.scaleX, let layerScaleY = layer.scaleY else { throw PhotoExportError.noCGImageInLayer }
 
+            let context = try createContext(size: pixelFrameSize, precision: PixelPrecisionType(cgImage: layerImage))
+
             context.draw(layerImage, in: CGRect(x: 0,
                                                 y: 0,
                                                 width: CGFloat(pixelFrameSize.width),
@@ -377,6 +444,7 @@ struct PhotoExporterService {
                 context.setShouldAntialias(false)
                 context.setLineWidth(lineWidthTransformed)
                 context.setLineCap(.round)
+                context.setLineJoin(.round)
 
                 let pencilStyle = drawing.currentPencilStyle.shapeStyle
                 let pencilStyleCG = drawing.currentPencilStyle.shapeStyleCG
@@ -386,9 +454,7 @@ struct PhotoExporterService {
                 } else {
                     if let pencilStyle = pencilStyle as? Color {
                         context.setStrokeColor(UIColor(pencilStyle).cgColor)
-                    } else if let cgLinearGradient = pencilStyleCG as? CGLinearGradient,
-                              let cgGradient = cgLinearGradient.cgGradient
-                    {
+                    } else if let cgLinearGradient = pencilStyleCG as? CGLinearGradient {
                         context.saveGState()
                         defer { context.restoreGState() }
 
@@ -412,10 +478,10 @@ struct PhotoExporterService {
 
                         context.scaleBy(x: abs(layer.scaleX ?? 1.0), y: abs(layer.scaleY ?? 1.0))
 
-                        context.drawLinearGradient(cgGradient,
-                                                   start: start,
-                                                   end: end,
-                                                   options: [.drawsAfterEndLocation, .drawsBeforeStartLocation])
+                        try gradientRasterizerService.drawGradient(cgLinearGradient,
+                                                                   start: start,
+                                                                   end: end,
+                                                                   in: context)
                     }
                 }
 
@@ -453,7 +519,7 @@ struct PhotoExporterService {
                                           height: contextHeight,
                                           bitsPerComponent: 8,
                                           bytesPerRow: 0,
-                                          space: CGColorSpaceCreateDeviceRGB(),
+                                          space: ColorManagementService.shared.workingColorSpace,
                                           bitmapInfo: CGImageAlphaInfo.premultipliedFirst.rawValue)
             else {
                 throw PhotoExportError.contextCreation(contextSize: .init(width: contextWidth, height: contextHeight))
@@ -488,27 +554,11 @@ struct PhotoExporterService {
                                             width: renderSizeType.sizeDividend,
                                             height: renderSizeType.sizeDividend))
                     }
-                } else if let cgLinearGradient = shapeStyleCG as? CGLinearGradient,
-                          let cgGradient = cgLinearGradient.cgGradient
-                {
-                    let startPoint = cgLinearGradient.startPoint
-                    let endPoint = cgLinearGradient.endPoint
-
-                    UIGraphicsBeginImageContext(CGSize(width: contextWidth, height: contextHeight))
-                    let gradientContext = UIGraphicsGetCurrentContext()!
-
-                    let startX = CGFloat(contextWidth) * cgLinearGradient.startPoint.x
-                    let startY = CGFloat(contextHeight) * cgLinearGradient.startPoint.y
-                    let endX = CGFloat(contextWidth) * cgLinearGradient.endPoint.x
-                    let endY = CGFloat(contextHeight) * cgLinearGradient.endPoint.y
-
-                    let start = CGPoint(x: startX, y: startY)
-                    let end = CGPoint(x: endX, y: endY)
-
-                    gradientContext.drawLinearGradient(cgGradient, start: start, end: end, options: [.drawsAfterEndLocation, .drawsBeforeStartLocation])
-
-                    let gradientImage = UIGraphicsGetImageFromCurrentImageContext()
-                    UIGraphicsEndImageContext()
+                } else if let cgLinearGradient = shapeStyleCG as? CGLinearGradient {
+                    let gradientImage = try gradientRasterizerService.makeImage(
+                        cgLinearGradient,
+                        size: CGSize(width: contextWidth, height: contextHeight),
+                        precision: PixelPrecisionType(cgImage: layerImage))
 
                     UIGraphicsBeginImageContext(CGSize(width: contextWidth, height: contextHeight))
                     let imageContext = UIGraphicsGetCurrentContext()!
@@ -530,7 +580,7 @@ struct PhotoExporterService {
 
                     UIGraphicsBeginImageContext(CGSize(width: contextWidth, height: contextHeight))
 
-                    context.draw(gradientImage!.cgImage!, in: CGRect(x: 0, y: 0, width: contextWidth, height: contextHeight))
+                    context.draw(gradientImage, in: CGRect(x: 0, y: 0, width: contextWidth, height: contextHeight))
 
                     context.draw(imageWithHoles!.cgImage!, in: CGRect(x: 0, y: 0, width: contextWidth, height: contextHeight))
                 }
@@ -692,125 +742,80 @@ struct PhotoExporterService {
     func renderTextLayer(textModelEntity: TextModelEntity) async throws -> CGImage {
         return try await Task {
             let text = textModelEntity.text
-            guard let font = UIFont(name: textModelEntity.fontName,
-                                    size: CGFloat(textModelEntity.fontSize.doubleValue * 1.08))
-            else { throw PhotoExportError.fontCreating }
+            let fontName = textModelEntity.fontName
+            let fontSize = CGFloat(textModelEntity.fontSize.doubleValue * 1.08)
             let borderSize = textModelEntity.borderSize.intValue
-            let textColor = UIColor(Color(hex: textModelEntity.textColorHex))
-            let borderColor = UIColor(Color(hex: textModelEntity.borderColorHex))
-
-            let attributes = [
-                NSAttributedString.Key.font: font,
-                NSAttributedString.Key.foregroundColor: textColor,
-                NSAttributedString.Key.strokeColor: borderColor,
-                NSAttributedString.Key.strokeWidth: -borderSize,
-            ]
-
-            let textWidth = text.size(withAttributes: attributes).width
-            let textHeight = text.size(withAttributes: attributes).height
-            let curveAngle = Angle(degrees: textModelEntity.curveDegrees.doubleValue)
-
-            let curveFactor: Double = { (x: Double) in
-                if x <= 0.5 {
-                    return 30.0
-                } else {
-                    return 0.0267
-                        * tan((x * 0.5 * .pi / 180.0) * 0.5 + .pi * 0.5)
-                }
-
-            }(abs(curveAngle.degrees))
-
-            let radius = ((textHeight + textWidth * 6.0) * curveFactor)
-                * copysign(-1.0, curveAngle.radians)
+            let textColorHex = textModelEntity.textColorHex
+            let borderColorHex = textModelEntity.borderColorHex
+            let curveDegrees = textModelEntity.curveDegrees.doubleValue
 
-            let newWidth =
-                max(textWidth * pow(abs(cos(curveAngle.radians * 0.5)), 1 / 2),
-                    2.0 * abs(radius) * sin(curveAngle.radians * 0.5) * sin(curveAngle.radians * 0.5)
-                        + textHeight) + textHeight * 0.25
-
-            let heightFactor = pow(abs(cos(curveAngle.radians * 0.5 - .pi * 0.5)), 1 / 2) * (2.0 * abs(radius) * sin(curveAngle.radians * 0.5) * sin(curveAngle.radians * 0.5))
+            let renderKey = "\(fontName)-\(fontSize)-\(borderSize)-\(textColorHex)-\(borderColorHex)-\(curveDegrees)-\(text)"
+            if let renderedImage = textRenderCacheService.renderedImage(forKey: renderKey) {
+                return renderedImage
+            }
 
-            let newHeight =
-                heightFactor + textHeight
+            let glyphAtlas = try textRenderCacheService.glyphAtlas(fontName: fontName,
+                                                                   fontSize: fontSize,
+                                                                   borderSize: borderSize,
+                                                                   textColorHex: textColorHex,
+                                                                   borderColorHex: borderColorHex)
+            {
+                guard let font = UIFont(name: fontName, size: fontSize) else { throw PhotoExportError.fontCreating }
+
+                return [
+                    NSAttributedString.Key.font: font,
+                    NSAttributedString.Key.foregroundColor: UIColor(Color(hex: textColorHex)),
+                    NSAttributedString.Key.strokeColor: UIColor(Color(hex: borderColorHex)),
+                    NSAttributedString.Key.strokeWidth: -borderSize,
+                ]
+            }
+            let attributes = glyphAtlas.attributes
 
-            let size = CGSize(
-                width: newWidth,
-                height: newHeight
-            )
+            let glyphs = try text.map { try glyphAtlas.glyph(for: String($0)) }
+            let layout = CurvedTextLayout(advances: glyphs.map(\.size.width),
+                                          textSize: text.size(withAttributes: attributes),
+                                          curveDegrees: curveDegrees)
 
             guard let context = CGContext(data: nil,
-                                          width: Int(size.width),
-                                          height: Int(size.height),
+                                          width: Int(layout.size.width),
+                                          height: Int(layout.size.height),
                                           bitsPerComponent: 8,
                                           bytesPerRow: 0,
-                                          space: CGColorSpaceCreateDeviceRGB(),
+                                          space: ColorManagementService.shared.workingColorSpace,
                                           bitmapInfo: CGImageAlphaInfo.premultipliedFirst.rawValue)
             else { throw PhotoExportError.contextCreation(contextSize:
-                .init(width: Int(size.width),
-                      height: Int(size.height))) }
-
-            context.translateBy(x: size.width / 2, y: size.height / 2)
-
-            let characters: [String] = text.map { String($0) }
-            let textLenght = characters.count
-
-            context.translateBy(x: 0, y: -radius + heightFactor * 0.5 * copysign(-1.0, -curveAngle.radians))
-
-            var arcs: [CGFloat] = []
+                .init(width: Int(layout.size.width),
+                      height: Int(layout.size.height))) }
 
-            for i in 0 ..< textLenght {
-                arcs += [chordToArc(chord: characters[i].size(withAttributes: attributes).width, radius: radius)]
-            }
-
-            let totalArc = arcs.reduce(0.0) { $0 + $1 }
-
-            var thetaI = .pi * 0.5 + totalArc * 0.5
+            context.translateBy(x: layout.size.width / 2, y: layout.size.height / 2)
+            context.translateBy(x: 0, y: layout.baselineOffset)
 
-            for i in 0 ..< textLenght {
-                thetaI -= arcs[i] * 0.5
-                centreText(context: context,
-                           text: characters[i],
-                           radius: radius,
-                           curve: thetaI,
-                           attributes: attributes,
-                           slantAngle: thetaI - .pi / 2)
-                thetaI -= arcs[i] * 0.5
+            for (glyph, placement) in zip(glyphs, layout.placements) {
+                centreGlyph(context: context, glyph: glyph, placement: placement)
             }
 
             guard let resultCGImage = context.makeImage() else { throw PhotoExportError.contextImageMaking }
 
-            let croppedImage = resultCGImage
+            textRenderCacheService.storeRenderedImage(resultCGImage, forKey: renderKey)
 
-            return croppedImage
+            return resultCGImage
         }.value
     }
 
-    private func chordToArc(chord: CGFloat, radius: CGFloat) -> CGFloat {
-        return 2 * asin(chord / (2 * radius))
-    }
-
-    private func getRadiusForText(text: String, attributes: [NSAttributedString.Key: Any]) -> CGFloat {
-        let smallestWidthOrHeight = min(text.size(withAttributes: attributes).height, text.size(withAttributes: attributes).width)
-        let heightOfFont = text.size(withAttributes: attributes).height
-        let radius = (smallestWidthOrHeight / 2) - heightOfFont + 5
-        return radius
-    }
-
-    private func centreText(context: CGContext,
-                            text: String,
-                            radius: CGFloat,
-                            curve: CGFloat,
-                            attributes: [NSAttributedString.Key: Any],
-                            slantAngle: CGFloat)
+    private func centreGlyph(context: CGContext,
+                             glyph: TextRenderCacheService.Glyph,
+                             placement: CurvedTextLayout.GlyphPlacement)
     {
         context.saveGState()
         context.scaleBy(x: 1, y: -1)
-        context.translateBy(x: radius * cos(curve), y: -(radius * sin(curve)))
-        context.rotate(by: -slantAngle)
-        let offset = text.size(withAttributes: attributes)
-        context.translateBy(x: -offset.width / 2, y: -offset.height / 2)
-        UIGraphicsPushContext(context)
-        text.draw(at: .zero, withAttributes: attributes)
+        context.translateBy(x: placement.center.x, y: placement.center.y)
+        context.rotate(by: placement.rotation)
+        context.translateBy(x: -glyph.size.width / 2, y: glyph.size.height / 2 + glyph.padding)
+        context.scaleBy(x: 1, y: -1)
+        context.draw(glyph.image, in: CGRect(x: -glyph.padding,
+                                             y: glyph.size.height + glyph.padding * 2.0 - CGFloat(glyph.image.height),
+                                             width: CGFloat(glyph.image.width),
+                                             height: CGFloat(glyph.image.height)))
         context.restoreGState()
     }
 }
@@ -8,13 +8,16 @@
 import Combine
 import CoreGraphics
 import Foundation
+import ImageIO
 import Photos
 import UIKit
+import UniformTypeIdentifiers
 
 final class PhotoLibraryService: ObservableObject {
     var mediaPublisher = PassthroughSubject<[PHAsset], Never>()
 
     private var imageCachingManager: PHCachingImageManager!
+    private let imageCache = ImageCacheService.shared
 
     func requestAuthorization(completion: @escaping (Bool) -> Void) {
         DispatchQueue.main.async {
@@ -69,6 +72,11 @@ final class PhotoLibraryService: ObservableObject {
                         desiredSize: CGSize,
                         contentMode: PHImageContentMode = .default) async throws -> UIImage
     {
+        let cacheKey = "\(localIdentifier)-\(Int(desiredSize.width))x\(Int(desiredSize.height))-\(contentMode.rawValue)"
+        if let cachedPhoto: UIImage = imageCache.object(forKey: cacheKey, in: .thumbnail) {
+            return cachedPhoto
+        }
+
         let asset: PHAsset? = fetchAsset(for: localIdentifier)
 
         guard let asset else { throw PhotoError.invalidLocalIdentifier(localIdentifier: localIdentifier) }
@@ -95,6 +103,10 @@ final class PhotoLibraryService: ObservableObject {
                     }
                 }
             }
+
+        if let cgImage = photo.cgImage {
+            imageCache.setObject(photo, forKey: cacheKey, in: .thumbnail, cost: cgImage.byteCost)
+        }
         return photo
     }
 
@@ -149,6 +161,20 @@ final class PhotoLibraryService: ObservableObject {
     private func saveFileLocally(data: Data,
                                  extension fileExtension: String?,
                                  folderName: String, fileName: String) throws -> URL
+    {
+        let fileURL = try localFileURL(extension: fileExtension, folderName: folderName, fileName: fileName)
+
+        do {
+            try data.write(to: fileURL, options: .atomic)
+            return fileURL
+        } catch {
+            throw FileError.store(url: fileURL)
+        }
+    }
+
+    private func localFileURL(extension fileExtension: String?,
+                              folderName: String,
+                              fileName: String) throws -> URL
     {
         let fileManager = FileManager.default
 
@@ -170,30 +196,207 @@ final class PhotoLibraryService: ObservableObject {
             fileURL = fileURL.appendingPathExtension(fileExtension)
         }
 
-        do {
-            try data.write(to: fileURL)
-            return fileURL
-        } catch {
-            throw FileError.store(url: fileURL)
-        }
+        return fileURL
     }
 
     func saveAssetsAndGetFileNames(assets: [PHAsset]) async throws -> [String] {
-        return try await withThrowingTaskGroup(of: String.self, returning: [String].self) { [unowned self] group in
-            var array = [String]()
-            for asset in assets {
+        return try await importAssets(assets).map(\.fileName)
+    }
+
+    func importAssets(_ assets: [PHAsset],
+                      options: PhotoImportOptions = PhotoImportOptions()) async throws -> [PhotoImportResult]
+    {
+        #if DEBUG
+        let startTime = Date().timeIntervalSince1970
+        #endif
+        let maxConcurrentImports = max(1, options.maxConcurrentImports)
+
+        let results = try await withThrowingTaskGroup(of: (Int, PhotoImportResult).self,
+                                                      returning: [PhotoImportResult].self)
+        { [unowned self] group in
+            var results = [PhotoImportResult?](repeating: nil, count: assets.count)
+
+            for (index, asset) in assets.enumerated() {
+                if index >= maxConcurrentImports, let (finishedIndex, result) = try await group.next() {
+                    results[finishedIndex] = result
+                }
                 group.addTask { [unowned self] in
-                    let (assetData, fileExtension)
-                        = try await fetchMediaDataAndExtensionFromPhotoLibrary(with: asset.localIdentifier)
-                    let savedFileURL = try await saveToDisk(data: assetData, extension: fileExtension)
-                    return savedFileURL.lastPathComponent
+                    try await (index, importAsset(asset, options: options))
+                }
+            }
+            for try await (index, result) in group {
+                results[index] = result
+            }
+            return results.compactMap { $0 }
+        }
+
+        #if DEBUG
+        let metrics = results.map(\.metrics).reduce(PhotoImportMetrics(), +)
+        print("imported", results.count, "assets,",
+              String(format: "%.1f", Double(metrics.byteCount) / 1048576.0), "MB,",
+              "transfer", String(format: "%.3f", metrics.transferDuration), "s,",
+              "decode", String(format: "%.3f", metrics.decodeDuration), "s,",
+              "total", String(format: "%.3f", Date().timeIntervalSince1970 - startTime), "s")
+        #endif
+
+        return results
+    }
+
+    private func importAsset(_ asset: PHAsset, options: PhotoImportOptions) async throws -> PhotoImportResult {
+        let resources = PHAssetResource.assetResources(for: asset)
+
+        guard let resource = resources.first(where: { $0.type == .fullSizePhoto })
+            ?? resources.first(where: { $0.type == .photo })
+            ?? resources.first
+        else {
+            throw PhotoError.noAssetResources(localIdentifier: asset.localIdentifier)
+        }
+
+        let fileExtension = URL(fileURLWithPath: resource.originalFilename).pathExtension
+        let fileName = UUID().uuidString
+        let fileURL = try localFileURL(extension: fileExtension, folderName: "UserMedia", fileName: fileName)
+        let streamURL = options.workingMaxPixelSize == nil
+            ? fileURL
+            : try localFileURL(extension: fileExtension, folderName: "UserMediaOriginals", fileName: fileName)
+
+        var metrics = PhotoImportMetrics()
+
+        let transferStartTime = Date().timeIntervalSince1970
+        metrics.byteCount = try await streamResource(resource, to: streamURL, chunkCapacity: options.chunkCapacity)
+        let decodeStartTime = Date().timeIntervalSince1970
+        metrics.transferDuration = decodeStartTime - transferStartTime
+
+        var workingImage: CGImage?
+        if let workingMaxPixelSize = options.workingMaxPixelSize {
+            workingImage = try storeWorkingCopy(of: streamURL, at: fileURL, maxPixelSize: workingMaxPixelSize)
+        }
+
+        let (proxy, thumbnail) = decodeImages(at: fileURL, workingImage: workingImage, options: options)
+        metrics.decodeDuration = Date().timeIntervalSince1970 - decodeStartTime
+
+        return PhotoImportResult(fileName: fileURL.lastPathComponent,
+                                 proxy: proxy,
+                                 thumbnail: thumbnail,
+                                 metrics: metrics)
+    }
+
+    // Chunks are delivered serially, so they are gathered into one reusable buffer
+    // and flushed to the file whenever it fills up.
+    private func streamResource(_ resource: PHAssetResource, to fileURL: URL, chunkCapacity: Int) async throws -> Int {
+        guard FileManager.default.createFile(atPath: fileURL.path, contents: nil),
+              let fileHandle = try? FileHandle(forWritingTo: fileURL)
+        else {
+            throw FileError.store(url: fileURL)
+        }
+
+        let requestOptions = PHAssetResourceRequestOptions()
+        requestOptions.isNetworkAccessAllowed = true
+
+        return try await withCheckedThrowingContinuation { continuation in
+            var pendingData = Data(capacity: chunkCapacity)
+            var byteCount = 0
+            var writeError: Error?
+
+            PHAssetResourceManager.default().requestData(for: resource, options: requestOptions) { chunk in
+                guard writeError == nil else { return }
+
+                pendingData.append(chunk)
+                byteCount += chunk.count
+                guard pendingData.count >= chunkCapacity else { return }
+
+                do {
+                    try fileHandle.write(contentsOf: pendingData)
+                    pendingData.removeAll(keepingCapacity: true)
+                } catch {
+                    writeError = FileError.store(url: fileURL)
+                }
+            } completionHandler: { error in
+                do {
+                    if let error = error ?? writeError { throw error }
+                    try fileHandle.write(contentsOf: pendingData)
+                    try fileHandle.close()
+                    continuation.resume(returning: byteCount)
+                } catch {
+                    try? fileHandle.close()
+                    try? FileManager.default.removeItem(at: fileURL)
+                    continuation.resume(throwing: error)
                 }
             }
-            for try await fileName in group {
-                array.append(fileName)
+        }
+    }
+
+    // Originals larger than the working size are kept aside for the final export, while the layer
+    // works on a copy decoded straight to that size through the subsampling thumbnail path.
+    private func storeWorkingCopy(of originalURL: URL, at fileURL: URL, maxPixelSize: Int) throws -> CGImage? {
+        let fileManager = FileManager.default
+
+        guard let imageSource = CGImageSourceCreateWithURL(originalURL as CFURL, nil),
+              let properties = CGImageSourceCopyPropertiesAtIndex(imageSource, 0, nil) as? [CFString: Any],
+              let pixelWidth = properties[kCGImagePropertyPixelWidth] as? Int,
+              let pixelHeight = properties[kCGImagePropertyPixelHeight] as? Int,
+              max(pixelWidth, pixelHeight) > maxPixelSize,
+              let workingImage = CGImageSourceCreateThumbnailAtIndex(imageSource, 0, [
+                  kCGImageSourceCreateThumbnailFromImageAlways: true,
+                  kCGImageSourceThumbnailMaxPixelSize: maxPixelSize,
+                  kCGImageSourceShouldCacheImmediately: true
+              ] as CFDictionary)
+        else {
+            do {
+                try fileManager.moveItem(at: originalURL, to: fileURL)
+            } catch {
+                throw FileError.store(url: fileURL)
             }
-            return array
+            return nil
         }
+
+        let imageType = CGImageSourceGetType(imageSource) ?? UTType.png.identifier as CFString
+
+        guard let destination = CGImageDestinationCreateWithURL(fileURL as CFURL, imageType, 1, nil)
+            ?? CGImageDestinationCreateWithURL(fileURL as CFURL, UTType.png.identifier as CFString, 1, nil)
+        else {
+            throw FileError.store(url: fileURL)
+        }
+
+        var destinationProperties: [CFString: Any] = [kCGImageDestinationLossyCompressionQuality: 0.95]
+        destinationProperties[kCGImagePropertyOrientation] = properties[kCGImagePropertyOrientation]
+
+        CGImageDestinationAddImage(destination, workingImage, destinationProperties as CFDictionary)
+        guard CGImageDestinationFinalize(destination) else { throw FileError.store(url: fileURL) }
+
+        try? fileManager.setAttributes([.modificationDate: Date()], ofItemAtPath: originalURL.path)
+
+        return workingImage
+    }
+
+    private func decodeImages(at fileURL: URL,
+                              workingImage: CGImage?,
+                              options: PhotoImportOptions) -> (proxy: CGImage?, thumbnail: CGImage?)
+    {
+        guard let imageSource = CGImageSourceCreateWithURL(fileURL as CFURL, nil) else { return (nil, nil) }
+
+        let proxy: CGImage?
+        switch options.proxySize {
+        case .none:
+            proxy = nil
+        case .original:
+            proxy = workingImage ?? CGImageSourceCreateImageAtIndex(imageSource, 0, [
+                kCGImageSourceShouldCacheImmediately: true
+            ] as CFDictionary)
+        case .maxPixelSize(let maxPixelSize):
+            proxy = CGImageSourceCreateThumbnailAtIndex(imageSource, 0, [
+                kCGImageSourceCreateThumbnailFromImageAlways: true,
+                kCGImageSourceThumbnailMaxPixelSize: maxPixelSize,
+                kCGImageSourceShouldCacheImmediately: true
+            ] as CFDictionary)
+        }
+
+        let thumbnail = CGImageSourceCreateThumbnailAtIndex(imageSource, 0, [
+            kCGImageSourceCreateThumbnailFromImageAlways: true,
+            kCGImageSourceCreateThumbnailWithTransform: true,
+            kCGImageSourceThumbnailMaxPixelSize: options.thumbnailMaxPixelSize
+        ] as CFDictionary)
+
+        return (proxy, thumbnail)
     }
 
     private func storeInPhotoAlbum(cgImage: CGImage,
@@ -0,0 +1,282 @@
+//
+//  RenderSchedulerService.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 25/07/2024.
+//
+
+import Foundation
+
+final class RenderSchedulerService {
+    // Disk writes outlive the project that scheduled them, so they never run on a per-project scheduler.
+    static let persistence = RenderSchedulerService()
+
+    enum Priority: Int, CaseIterable, Comparable {
+        case thumbnail
+        case persistence
+        case commit
+        case interactivePreview
+
+        var taskPriority: TaskPriority {
+            switch self {
+            case .thumbnail:
+                .background
+            case .persistence:
+                .utility
+            case .commit:
+                .userInitiated
+            case .interactivePreview:
+                .high
+            }
+        }
+
+        static func < (lhs: Priority, rhs: Priority) -> Bool {
+            return lhs.rawValue < rhs.rawValue
+        }
+    }
+
+    final class Token {
+        fileprivate let id = UUID()
+        fileprivate weak var scheduler: RenderSchedulerService?
+
+        fileprivate init(scheduler: RenderSchedulerService) {
+            self.scheduler = scheduler
+        }
+
+        func cancel() {
+            scheduler?.cancel(jobID: id)
+        }
+    }
+
+    struct Metrics {
+        var queueDepths = [Priority: Int]()
+        var peakQueueDepths = [Priority: Int]()
+        var completedCounts = [Priority: Int]()
+        var cancelledCounts = [Priority: Int]()
+        var coalescedCounts = [Priority: Int]()
+        var totalWaitDurations = [Priority: TimeInterval]()
+        var totalRunDurations = [Priority: TimeInterval]()
+
+        func averageWaitDuration(of priority: Priority) -> TimeInterval {
+            return (totalWaitDurations[priority] ?? 0.0) / Double(max(completedCounts[priority] ?? 0, 1))
+        }
+
+        func averageRunDuration(of priority: Priority) -> TimeInterval {
+            return (totalRunDurations[priority] ?? 0.0) / Double(max(completedCounts[priority] ?? 0, 1))
+        }
+    }
+
+    private struct Job {
+        let id: UUID
+        let key: String?
+        let priority: Priority
+        let enqueueDate: Date
+        let run: () async -> Void
+        let cancel: () -> Void
+    }
+
+    private struct RunningJob {
+        let key: String?
+        let priority: Priority
+        let task: Task<Void, Never>
+    }
+
+    let maxConcurrentJobs: Int
+
+    private var pendingJobs = [Job]()
+    private var runningJobs = [UUID: RunningJob]()
+    private var metrics = Metrics()
+    private let lock = NSLock()
+
+    init(maxConcurrentJobs: Int = max(2, ProcessInfo.processInfo.activeProcessorCount / 2)) {
+        self.maxConcurrentJobs = maxConcurrentJobs
+    }
+
+    var currentMetrics: Metrics {
+        lock.lock()
+        defer { lock.unlock() }
+        return metrics
+    }
+
+    // A job with the same key supersedes an older one: a queued job is dropped, a running one is cancelled
+    // and the new job waits for it to return, so jobs sharing a key never overlap.
+    func perform<T>(_ priority: Priority,
+                    key: String? = nil,
+                    operation: @escaping () async throws -> T) async throws -> T
+    {
+        let token = Token(scheduler: self)
+
+        return try await withTaskCancellationHandler {
+            try await withCheckedThrowingContinuation { continuation in
+                enqueue(Job(id: token.id,
+                            key: key,
+                            priority: priority,
+                            enqueueDate: .now,
+                            run: {
+                                do {
+                                    try Task.checkCancellation()
+                                    let value = try await operation()
+                                    try Task.checkCancellation()
+                                    continuation.resume(returning: value)
+                                } catch {
+                                    continuation.resume(throwing: error)
+                                }
+                            },
+                            cancel: { continuation.resume(throwing: CancellationError()) }))
+            }
+        } onCancel: {
+            token.cancel()
+        }
+    }
+
+    @discardableResult
+    func schedule(_ priority: Priority,
+                  key: String? = nil,
+                  operation: @escaping () async throws -> Void) -> Token
+    {
+        let token = Token(scheduler: self)
+
+        enqueue(Job(id: token.id,
+                    key: key,
+                    priority: priority,
+                    enqueueDate: .now,
+                    run: {
+                        do {
+                            try await operation()
+                        } catch {
+                            if !(error is CancellationError) {
+                                print(error)
+                            }
+                        }
+                    },
+                    cancel: {}))
+        return token
+    }
+
+    func cancel(key: String) {
+        lock.lock()
+        let cancelledJobs = removePendingJobs { $0.key == key }
+        runningJobs.values.filter { $0.key == key }.forEach { $0.task.cancel() }
+        lock.unlock()
+
+        cancelledJobs.forEach { $0.cancel() }
+    }
+
+    func cancelAll(below priority: Priority) {
+        lock.lock()
+        let cancelledJobs = removePendingJobs { $0.priority < priority }
+        runningJobs.values.filter { $0.priority < priority }.forEach { $0.task.cancel() }
+        lock.unlock()
+
+        cancelledJobs.forEach { $0.cancel() }
+    }
+
+    private func cancel(jobID: UUID) {
+        lock.lock()
+        let cancelledJobs = removePendingJobs { $0.id == jobID }
+        runningJobs[jobID]?.task.cancel()
+        lock.unlock()
+
+        cancelledJobs.forEach { $0.cancel() }
+    }
+
+    private func enqueue(_ job: Job) {
+        lock.lock()
+        var supersededJobs = [Job]()
+        if let key = job.key {
+            supersededJobs = removePendingJobs { $0.key == key }
+            runningJobs.values.filter { $0.key == key }.forEach { $0.task.cancel() }
+            metrics.coalescedCounts[job.priority, default: 0] += supersededJobs.count
+        }
+
+        pendingJobs.append(job)
+        metrics.queueDepths[job.priority, default: 0] += 1
+        metrics.peakQueueDepths[job.priority] = max(metrics.peakQueueDepths[job.priority] ?? 0,
+                                                    metrics.queueDepths[job.priority] ?? 0)
+        lock.unlock()
+
+        supersededJobs.forEach { $0.cancel() }
+        startPendingJobs()
+    }
+
+    // One worker stays reserved for interactive previews, so they never queue behind background work.
+    private func startPendingJobs() {
+        lock.lock()
+        defer { lock.unlock() }
+
+        while let index = nextJobIndex() {
+            let job = pendingJobs.remove(at: index)
+            metrics.queueDepths[job.priority, default: 0] -= 1
+
+            let startDate = Date.now
+            let task = Task(priority: job.priority.taskPriority) { [weak self] in
+                await job.run()
+                self?.finish(job, startDate: startDate, isCancelled: Task.isCancelled)
+            }
+            runningJobs[job.id] = RunningJob(key: job.key, priority: job.priority, task: task)
+        }
+    }
+
+    private func nextJobIndex() -> Int? {
+        let runningKeys = Set(runningJobs.values.compactMap(\.key))
+        let startableIndices = pendingJobs.indices.filter { index in
+            pendingJobs[index].key.map { !runningKeys.contains($0) } ?? true
+        }
+
+        guard let index = startableIndices.max(by: { lhs, rhs in
+            pendingJobs[lhs].priority == pendingJobs[rhs].priority
+                ? lhs > rhs
+                : pendingJobs[lhs].priority < pendingJobs[rhs].priority
+        }) else { return nil }
+
+        let workerLimit = pendingJobs[index].priority == .interactivePreview ? maxConcurrentJobs : maxConcurrentJobs - 1
+        return runningJobs.count < workerLimit ? index : nil
+    }
+
+    private func finish(_ job: Job, startDate: Date, isCancelled: Bool) {
+        lock.lock()
+        runningJobs[job.id] = nil
+
+        if isCancelled {
+            metrics.cancelledCounts[job.priority, default: 0] += 1
+        } else {
+            metrics.completedCounts[job.priority, default: 0] += 1
+            metrics.totalWaitDurations[job.priority, default: 0.0] += startDate.timeIntervalSince(job.enqueueDate)
+            metrics.totalRunDurations[job.priority, default: 0.0] += Date.now.timeIntervalSince(startDate)
+        }
+        lock.unlock()
+
+        startPendingJobs()
+    }
+
+    private func removePendingJobs(where predicate: (Job) -> Bool) -> [Job] {
+        let removedJobs = pendingJobs.filter(predicate)
+        pendingJobs.removeAll(where: predicate)
+
+        for job in removedJobs {
+            metrics.queueDepths[job.priority, default: 0] -= 1
+            metrics.cancelledCounts[job.priority, default: 0] += 1
+        }
+        return removedJobs
+    }
+}
+
+#if DEBUG
+extension RenderSchedulerService {
+    func printMetrics() {
+        let metrics = currentMetrics
+
+        for priority in Priority.allCases.reversed() {
+            print("""
+            \(priority): depth \(metrics.queueDepths[priority] ?? 0) \
+            (peak \(metrics.peakQueueDepths[priority] ?? 0)), \
+            completed \(metrics.completedCounts[priority] ?? 0), \
+            cancelled \(metrics.cancelledCounts[priority] ?? 0), \
+            coalesced \(metrics.coalescedCounts[priority] ?? 0), \
+            wait \(String(format: "%.1f", metrics.averageWaitDuration(of: priority) * 1000.0)) ms, \
+            run \(String(format: "%.1f", metrics.averageRunDuration(of: priority) * 1000.0)) ms
+            """)
+        }
+    }
+}
+#endif
@@ -0,0 +1,245 @@
+//
+//  StrokeRasterizerService.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 11/07/2024.
+//
+
+import SwiftUI
+
+// Rasterization runs on a private serial queue so long strokes never stall the main thread;
+// the canvas keeps previewing vector paths while the raster is kept ready for confirmation.
+final class StrokeRasterizerService {
+    let baseImage: CGImage
+    let frameSize: CGSize
+
+    private let scaleX: Double
+    private let scaleY: Double
+    private let queue = DispatchQueue(label: "StrokeRasterizerService", qos: .userInitiated)
+    private var raster: StrokeRaster?
+
+    init(baseImage: CGImage, frameSize: CGSize, scaleX: Double, scaleY: Double) {
+        self.baseImage = baseImage
+        self.frameSize = frameSize
+        self.scaleX = scaleX
+        self.scaleY = scaleY
+    }
+
+    static func canRasterize(_ drawing: DrawingModel) -> Bool {
+        return drawing.currentPencilType == .eraser || drawing.currentPencilStyle.shapeStyle is Color
+    }
+
+    func update(drawings: [DrawingModel], currentDrawing: DrawingModel) {
+        queue.async { [self] in
+            do {
+                try preparedRaster().update(drawings: drawings, currentDrawing: currentDrawing)
+            } catch {
+                print(error)
+            }
+        }
+    }
+
+    func makeImage(from drawings: [DrawingModel]) async throws -> CGImage? {
+        return try await withCheckedThrowingContinuation { continuation in
+            queue.async { [self] in
+                continuation.resume(with: Result { try preparedRaster().makeImage(from: drawings) })
+            }
+        }
+    }
+
+    private func preparedRaster() throws -> StrokeRaster {
+        if let raster { return raster }
+
+        let raster = try StrokeRaster(baseImage: baseImage, frameSize: frameSize, scaleX: scaleX, scaleY: scaleY)
+        self.raster = raster
+        return raster
+    }
+}
+
+private final class StrokeRaster {
+    private let baseImage: CGImage
+    private let buffer: PixelBuffer
+    private let strokeCoverage: UnsafeMutablePointer<UInt8>
+    private let pixelRatio: SIMD2<Float>
+    private let isFlippedHorizontally: Bool
+    private let isFlippedVertically: Bool
+
+    private var renderedDrawingCount = 0
+    private var activeStroke: DrawingModel?
+    private var activeStrokeRenderedSegmentCount = 0
+    private var activeStrokeDirtyRows: Range<Int>?
+
+    private(set) var isSupported = true
+
+    init(baseImage: CGImage, frameSize: CGSize, scaleX: Double, scaleY: Double) throws {
+        self.baseImage = baseImage
+        self.buffer = try PixelBuffer(cgImage: baseImage, precision: PixelPrecisionType(cgImage: baseImage))
+        self.strokeCoverage = UnsafeMutablePointer<UInt8>.allocate(capacity: buffer.width * buffer.height)
+        self.strokeCoverage.initialize(repeating: 0, count: buffer.width * buffer.height)
+        self.pixelRatio = SIMD2(Float(CGFloat(buffer.width) / frameSize.width),
+                                Float(CGFloat(buffer.height) / frameSize.height))
+        self.isFlippedHorizontally = scaleX < 0.0
+        self.isFlippedVertically = scaleY < 0.0
+    }
+
+    deinit {
+        strokeCoverage.deallocate()
+    }
+
+    func update(drawings: [DrawingModel], currentDrawing: DrawingModel) throws {
+        guard isSupported else { return }
+        guard (drawings + [currentDrawing]).allSatisfy(StrokeRasterizerService.canRasterize) else {
+            isSupported = false
+            return
+        }
+
+        if drawings.count == renderedDrawingCount + 1,
+           let activeStroke,
+           isContinuation(of: activeStroke, drawings[renderedDrawingCount])
+        {
+            appendSegments(of: drawings[renderedDrawingCount], from: activeStrokeRenderedSegmentCount)
+            finishActiveStroke()
+        } else if drawings.count != renderedDrawingCount
+            || !(activeStroke.map { isContinuation(of: $0, currentDrawing) } ?? true)
+        {
+            try rebuild(drawings: drawings)
+        }
+
+        appendSegments(of: currentDrawing, from: activeStroke == nil ? 0 : activeStrokeRenderedSegmentCount)
+    }
+
+    func makeImage(from drawings: [DrawingModel]) throws -> CGImage? {
+        try update(drawings: drawings, currentDrawing: DrawingModel())
+        guard isSupported else { return nil }
+
+        return try buffer.makeCGImage()
+    }
+
+    private func isContinuation(of renderedStroke: DrawingModel, _ drawing: DrawingModel) -> Bool {
+        return drawing.currentPencilType == renderedStroke.currentPencilType
+            && drawing.currentPencilSize == renderedStroke.currentPencilSize
+            && drawing.currentPencilStyle == renderedStroke.currentPencilStyle
+            && drawing.stroke.stableSegmentCount(isSmoothed: drawing.isSmoothed) >= activeStrokeRenderedSegmentCount
+            && drawing.stroke.committedPoints.first == renderedStroke.stroke.committedPoints.first
+    }
+
+    private func rebuild(drawings: [DrawingModel]) throws {
+        let context = try buffer.createContext()
+        context.clear(CGRect(origin: .zero, size: buffer.size))
+        context.draw(baseImage, in: CGRect(origin: .zero, size: buffer.size))
+
+        finishActiveStroke()
+
+        for drawing in drawings {
+            appendSegments(of: drawing, from: 0)
+            finishActiveStroke()
+        }
+        renderedDrawingCount = drawings.count
+    }
+
+    private func finishActiveStroke() {
+        if let activeStrokeDirtyRows {
+            let start = activeStrokeDirtyRows.lowerBound * buffer.width
+            strokeCoverage.advanced(by: start).update(repeating: 0, count: activeStrokeDirtyRows.count * buffer.width)
+        }
+        if activeStroke != nil {
+            renderedDrawingCount += 1
+        }
+        activeStroke = nil
+        activeStrokeRenderedSegmentCount = 0
+        activeStrokeDirtyRows = nil
+    }
+
+    private func appendSegments(of drawing: DrawingModel, from startIndex: Int) {
+        let segmentCount = drawing.stroke.stableSegmentCount(isSmoothed: drawing.isSmoothed)
+        guard startIndex < segmentCount else { return }
+
+        let radius = Float(drawing.currentPencilSize) * (pixelRatio.x * pixelRatio.y).squareRoot() * 0.5
+        let paint = strokePaint(for: drawing)
+
+        for index in startIndex ..< segmentCount {
+            var start = pixelPosition(of: drawing.stroke.point(at: max(index - 1, 0)))
+            for vertex in drawing.stroke.flattenedSegment(index, isSmoothed: drawing.isSmoothed) {
+                let end = pixelPosition(of: vertex)
+                rasterizeSegment(from: start, to: end, radius: radius,
+                                 paint: paint, isErasing: drawing.currentPencilType == .eraser)
+                start = end
+            }
+        }
+        activeStroke = drawing
+        activeStrokeRenderedSegmentCount = segmentCount
+    }
+
+    private func pixelPosition(of position: CGPoint) -> SIMD2<Float> {
+        var pixelPosition = SIMD2(Float(position.x), Float(position.y)) * pixelRatio
+        if isFlippedHorizontally { pixelPosition.x = Float(buffer.width) - pixelPosition.x }
+        if isFlippedVertically { pixelPosition.y = Float(buffer.height) - pixelPosition.y }
+        return pixelPosition
+    }
+
+    private func strokePaint(for drawing: DrawingModel) -> SIMD4<Float> {
+        guard drawing.currentPencilType != .eraser,
+              let color = drawing.currentPencilStyle.shapeStyle as? Color
+        else { return SIMD4(0.0, 0.0, 0.0, 255.0) }
+
+        let components = ColorManagementService.shared.workingComponents(of: UIColor(color).cgColor)
+
+        return SIMD4(components.x * components.w,
+                     components.y * components.w,
+                     components.z * components.w,
+                     components.w) * 255.0
+    }
+
+    private func rasterizeSegment(from start: SIMD2<Float>,
+                                  to end: SIMD2<Float>,
+                                  radius: Float,
+                                  paint: SIMD4<Float>,
+                                  isErasing: Bool)
+    {
+        let maxRadius = radius + 1.0
+        let minX = max(Int((min(start.x, end.x) - maxRadius).rounded(.down)), 0)
+        let maxX = min(Int((max(start.x, end.x) + maxRadius).rounded(.up)), buffer.width)
+        let minY = max(Int((min(start.y, end.y) - maxRadius).rounded(.down)), 0)
+        let maxY = min(Int((max(start.y, end.y) + maxRadius).rounded(.up)), buffer.height)
+        guard minX < maxX, minY < maxY else { return }
+
+        activeStrokeDirtyRows = activeStrokeDirtyRows.map {
+            min($0.lowerBound, minY) ..< max($0.upperBound, maxY)
+        } ?? minY ..< maxY
+
+        let direction = end - start
+        let lengthSquared = max((direction * direction).sum(), .leastNormalMagnitude)
+        let paintAlpha = paint.w / 255.0
+        let width = buffer.width
+
+        DispatchQueue.concurrentPerform(rowCount: maxY - minY, minimumRowsPerBand: 32) { rows in
+            for y in rows.lowerBound + minY ..< rows.upperBound + minY {
+                for x in minX ..< maxX {
+                    let pixelCenter = SIMD2<Float>(Float(x) + 0.5, Float(y) + 0.5)
+                    let projection = min(max(((pixelCenter - start) * direction).sum() / lengthSquared, 0.0), 1.0)
+                    let delta = pixelCenter - (start + direction * projection)
+                    let coverage = min(max(radius - (delta * delta).sum().squareRoot() + 0.5, 0.0), 1.0)
+
+                    let coverageIndex = y * width + x
+                    let previousCoverage = Float(strokeCoverage[coverageIndex]) / 255.0
+                    guard coverage > previousCoverage else { continue }
+
+                    strokeCoverage[coverageIndex] = UInt8((coverage * 255.0).rounded())
+
+                    let current = buffer.pixel(x: x, y: y)
+                    if isErasing {
+                        let remaining = 1.0 - previousCoverage
+                        let base = remaining > 1.0 / 255.0 ? current / remaining : .zero
+                        buffer.setPixel(x: x, y: y, base * (1.0 - coverage))
+                    } else {
+                        let remaining = 1.0 - paintAlpha * previousCoverage
+                        let base = remaining > 1.0 / 255.0
+                            ? (current - paint * previousCoverage) / remaining
+                            : .zero
+                        buffer.setPixel(x: x, y: y, paint * coverage + base * (1.0 - paintAlpha * coverage))
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,93 @@
+//
+//  TextRenderCacheService.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 16/07/2024.
+//
+
+import UIKit
+
+final class TextRenderCacheService {
+    struct Glyph {
+        let image: CGImage
+        let size: CGSize
+        let padding: CGFloat
+    }
+
+    final class GlyphAtlas {
+        let attributes: [NSAttributedString.Key: Any]
+        let padding: CGFloat
+
+        private var glyphs: [String: Glyph] = [:]
+        private let lock = NSLock()
+
+        init(attributes: [NSAttributedString.Key: Any], padding: CGFloat) {
+            self.attributes = attributes
+            self.padding = padding
+        }
+
+        func glyph(for character: String) throws -> Glyph {
+            lock.lock()
+            defer { lock.unlock() }
+
+            if let glyph = glyphs[character] { return glyph }
+
+            let glyph = try rasterize(character)
+            glyphs[character] = glyph
+            return glyph
+        }
+
+        private func rasterize(_ character: String) throws -> Glyph {
+            let size = character.size(withAttributes: attributes)
+            let contextSize = CGSize(width: (size.width + padding * 2.0).rounded(.up),
+                                     height: (size.height + padding * 2.0).rounded(.up))
+
+            guard let context = CGContext(data: nil,
+                                          width: max(Int(contextSize.width), 1),
+                                          height: max(Int(contextSize.height), 1),
+                                          bitsPerComponent: 8,
+                                          bytesPerRow: 0,
+                                          space: ColorManagementService.shared.workingColorSpace,
+                                          bitmapInfo: CGImageAlphaInfo.premultipliedFirst.rawValue)
+            else { throw PhotoExportError.contextCreation(contextSize: contextSize) }
+
+            context.translateBy(x: 0.0, y: contextSize.height)
+            context.scaleBy(x: 1.0, y: -1.0)
+
+            UIGraphicsPushContext(context)
+            character.draw(at: CGPoint(x: padding, y: padding), withAttributes: attributes)
+            UIGraphicsPopContext()
+
+            guard let image = context.makeImage() else { throw PhotoExportError.contextImageMaking }
+            return Glyph(image: image, size: size, padding: padding)
+        }
+    }
+
+    private let glyphAtlasCache = NSCache<NSString, GlyphAtlas>()
+    private let imageCache = ImageCacheService.shared
+    private let cacheKeyPrefix = "text/"
+
+    func glyphAtlas(fontName: String,
+                    fontSize: CGFloat,
+                    borderSize: Int,
+                    textColorHex: String,
+                    borderColorHex: String,
+                    attributes: () throws -> [NSAttributedString.Key: Any]) rethrows -> GlyphAtlas
+    {
+        let key = "\(fontName)-\(fontSize)-\(borderSize)-\(textColorHex)-\(borderColorHex)" as NSString
+        if let glyphAtlas = glyphAtlasCache.object(forKey: key) { return glyphAtlas }
+
+        let padding = (fontSize * (0.25 + CGFloat(borderSize) / 100.0)).rounded(.up) + 2.0
+        let glyphAtlas = try GlyphAtlas(attributes: attributes(), padding: padding)
+        glyphAtlasCache.setObject(glyphAtlas, forKey: key)
+        return glyphAtlas
+    }
+
+    func renderedImage(forKey key: String) -> CGImage? {
+        return imageCache.image(forKey: cacheKeyPrefix + key, in: .renderGraph)
+    }
+
+    func storeRenderedImage(_ image: CGImage, forKey key: String) {
+        imageCache.setImage(image, forKey: cacheKeyPrefix + key, in: .renderGraph)
+    }
+}
@@ -0,0 +1,93 @@
+//
+//  FrameCoalescer.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 25/07/2024.
+//
+
+import Combine
+import QuartzCore
+
+// Delivers the latest value at most once per display frame, then a single settle event
+// once no value has arrived for `settleInterval`. Frame events drive rendering, the
+// settle event only commits, so the last value is never rendered twice.
+final class FrameCoalescer<Value> {
+    struct GestureMetrics {
+        var receivedCount = 0
+        var deliveredCount = 0
+    }
+
+    let subject = PassthroughSubject<(Value, GestureEventPhaseType), Never>()
+
+    private let settleInterval: TimeInterval
+    private let label: String?
+
+    private var pendingValue: Value?
+    private var lastValue: Value?
+    private var lastReceiveTimestamp: CFTimeInterval = 0.0
+    private var displayLink: CADisplayLink?
+    private var metrics = GestureMetrics()
+
+    init(settleInterval: TimeInterval, label: String? = nil) {
+        self.settleInterval = settleInterval
+        self.label = label
+    }
+
+    deinit {
+        displayLink?.invalidate()
+    }
+
+    func receive(_ value: Value) {
+        pendingValue = value
+        lastValue = value
+        lastReceiveTimestamp = CACurrentMediaTime()
+        metrics.receivedCount += 1
+
+        guard displayLink == nil else { return }
+
+        let displayLink = CADisplayLink(target: DisplayLinkTarget { [weak self] link in
+            self?.step(link)
+        }, selector: #selector(DisplayLinkTarget.step(_:)))
+        displayLink.add(to: .main, forMode: .common)
+        self.displayLink = displayLink
+    }
+
+    func invalidate() {
+        displayLink?.invalidate()
+        displayLink = nil
+        pendingValue = nil
+        lastValue = nil
+    }
+
+    private func step(_ link: CADisplayLink) {
+        if let pendingValue {
+            self.pendingValue = nil
+            metrics.deliveredCount += 1
+            subject.send((pendingValue, .frame))
+        } else if link.timestamp - lastReceiveTimestamp >= settleInterval, let lastValue {
+            self.lastValue = nil
+            displayLink?.invalidate()
+            displayLink = nil
+
+            #if DEBUG
+            print("\(label ?? "Gesture"): \(metrics.receivedCount) events, \(metrics.deliveredCount) frame renders")
+            #endif
+            metrics = GestureMetrics()
+
+            subject.send((lastValue, .settle))
+        }
+    }
+}
+
+// CADisplayLink retains its target, so the coalescer is only referenced weakly through it.
+private final class DisplayLinkTarget: NSObject {
+    let handler: (CADisplayLink) -> Void
+
+    init(handler: @escaping (CADisplayLink) -> Void) {
+        self.handler = handler
+    }
+
+    @objc func step(_ link: CADisplayLink) {
+        handler(link)
+    }
+}
@@ -76,8 +76,17 @@ final class AddProjectViewModel: ObservableObject {
     func createProject() async throws -> ImageProjectEntity {
         let projectEntity = ImageProjectEntity(id: UUID(), title: "New photo project")
         let projectModel = ImageProjectModel(imageProjectEntity: projectEntity)
-        let fileNames = try await photoService.saveAssetsAndGetFileNames(assets: selectedAssets)
-        try projectModel.insertPhotosEntityToProject(fileNames: fileNames)
+        let importResults = try await photoService.importAssets(selectedAssets)
+        try projectModel.insertPhotosEntityToProject(fileNames: importResults.map(\.fileName))
+
+        if let thumbnail = importResults.first?.thumbnail,
+           let thumbnailData = UIImage(cgImage: thumbnail).jpegData(compressionQuality: 0.8)
+        {
+            _ = try? await photoService.saveToDisk(data: thumbnailData,
+                                                   extension: "JPEG",
+                                                   folderName: projectModel.imageProjectThumbnailFolderName,
+                                                   fileName: projectEntity.id!.uuidString)
+        }
         return projectEntity
     }
 }
@@ -14,12 +14,16 @@ import SwiftUI
 final class ImageProjectViewModel: ObservableObject {
     @Published var projectModel: ImageProjectModel
 
-    @Published var previewPhoto: CGImage?
+    @Published var previewPhoto: CGImage? {
+        didSet { trackImage(at: \.previewPhoto, forKey: "previewPhoto", isPinned: isExportSheetPresented) }
+    }
     @Published var selectedPhotos = [PHAsset]()
     @Published var libraryPhotos = [PHAsset]()
     @Published var isPermissionGranted = true
 
-    @Published var currentTool: (any Tool)?
+    @Published var currentTool: (any Tool)? {
+        didSet { imageCache.setPinned(isInNewCGImagePreview, forKey: imageCacheKeyPrefix + "originalCGImage", in: .preview) }
+    }
     @Published var currentCategory: (any Category)?
     @Published var currentFilter: FilterType?
 
@@ -29,7 +33,9 @@ final class ImageProjectViewModel: ObservableObject {
     @Published var lastCropModel: CropModel = .init()
     @Published var magicWandModel: MagicWandModel = .init()
 
-    @Published var originalCGImage: CGImage!
+    @Published var originalCGImage: CGImage! {
+        didSet { trackImage(at: \.originalCGImage, forKey: "originalCGImage", isPinned: isInNewCGImagePreview) }
+    }
 
     @Published var workspaceSize: CGSize?
 
@@ -41,15 +47,22 @@ final class ImageProjectViewModel: ObservableObject {
     @Published var layerToDelete: LayerModel?
     @Published var activeLayer: LayerModel?
 
-    @Published var projectLayers = [LayerModel]()
+    @Published var projectLayers = [LayerModel]() {
+        didSet { cachedLayerSnappingIndex = nil }
+    }
     @Published var drawings: [DrawingModel] = []
 
     @Published var revertModels: [RevertModelType: RevertModel] = [:]
 
     @Published var layersToMerge: [LayerModel] = .init()
+    @Published var isColorSamplingActive = false
+    @Published var isDownsamplingImports = true
 
     @Published var isSnapshotCurrentlyLoading = false
-    @Published var isExportSheetPresented = false
+    // The export sheet shows previewPhoto, so it must not be evicted from under it.
+    @Published var isExportSheetPresented = false {
+        didSet { imageCache.setPinned(isExportSheetPresented, forKey: imageCacheKeyPrefix + "previewPhoto", in: .preview) }
+    }
     @Published var isGradientViewPresented = false
     @Published var isKeyboardOpen = false
     @Published var lastLeftFloatingButtonAction: FloatingButtonActionType = .back
@@ -109,8 +122,6 @@ final class ImageProjectViewModel: ObservableObject {
     let pencilChangedSubject = PassthroughSubject<Void, Never>()
     let performToolActionSubject = PassthroughSubject<any Tool, Never>()
     let floatingButtonClickedSubject = PassthroughSubject<FloatingButtonActionType, Never>()
-    var saveLayerImageSubject =
-        PassthroughSubject<(fileName: String, cgImage: CGImage), Never>()
 
     var leftFloatingButtonActionType = FloatingButtonActionType.back
     var rightFloatingButtonActionType = FloatingButtonActionType.confirm
@@ -118,10 +129,21 @@ final class ImageProjectViewModel: ObservableObject {
     var centerButtonFunction: (() -> Void)?
 
     private var cancellables = Set<AnyCancellable>()
-    var renderTask: Task<Void, Error>?
 
     private var photoLibraryService = PhotoLibraryService()
     private var photoExporterService = PhotoExporterService()
+    private let editStackRenderService = EditStackRenderService()
+    private let renderScheduler = RenderSchedulerService()
+    private let imageCache = ImageCacheService.shared
+    private let imageCacheKeyPrefix = UUID().uuidString + "/"
+    private var strokeRasterizer: StrokeRasterizerService?
+    private var cachedLayerSnappingIndex: LayerSnappingIndex?
+    // Checkpoint files dropped from a redo tail, keyed by file name, until no snapshot refers to them.
+    private var discardedCheckpointFilePaths = [String: String]()
+    private let layerHitTestIndex = LayerHitTestIndex()
+    private let layerHitTestAlphaThreshold: UInt8 = 8
+    private let colorSamplingService = ColorSamplingService()
+    var colorSampleSize: ColorSamplingService.SampleSize = .threeByThree
 
     var currentRevertModelType: RevertModelType {
         return if let currentTool = currentTool as? LayerToolType, currentTool == .draw {
@@ -189,6 +211,7 @@ final class ImageProjectViewModel: ObservableObject {
                 } else {
                     layerModel = LayerModel(photoEntity: photoEntity)
                 }
+                layerModel.removeObsoleteOriginalFile()
 
                 if projectModel.lastEditDate == nil && isFirst {
                     isFirst = false
@@ -209,6 +232,11 @@ final class ImageProjectViewModel: ObservableObject {
             }
         }
         setupSubscriptions()
+        for layerModel in projectLayers where layerModel.committedCGImage == nil {
+            Task { [unowned self] in
+                await self.replayEditStack(of: layerModel)
+            }
+        }
         let latestSnapshot = createSnapshot()
         for model in revertModels.values {
             model.latestSnapshot = latestSnapshot
@@ -217,6 +245,30 @@ final class ImageProjectViewModel: ObservableObject {
 
     deinit {
         print("vm deinited")
+        imageCache.removeObjects(in: .preview, withKeyPrefix: imageCacheKeyPrefix)
+        #if DEBUG
+        renderScheduler.printMetrics()
+        imageCache.printMetrics()
+        #endif
+    }
+
+    // Images held here stay strong references; the cache only accounts for them and,
+    // on eviction, has the view model let go of the evicted one.
+    private func trackImage(at keyPath: ReferenceWritableKeyPath<ImageProjectViewModel, CGImage?>,
+                            forKey key: String,
+                            isPinned: Bool = false)
+    {
+        guard let image = self[keyPath: keyPath] else {
+            imageCache.removeObject(forKey: imageCacheKeyPrefix + key, in: .preview)
+            return
+        }
+
+        imageCache.setImage(image, forKey: imageCacheKeyPrefix + key, in: .preview, isPinned: isPinned) { [weak self] in
+            Task { @MainActor [weak self] in
+                guard let self, self[keyPath: keyPath] === image else { return }
+                self[keyPath: keyPath] = nil
+            }
+        }
     }
 
     func setupAddAssetsToProject() {
@@ -237,34 +289,68 @@ final class ImageProjectViewModel: ObservableObject {
     }
 
     private func setupSubscriptions() {
-        saveLayerImageSubject
-            .throttleAndDebounce(throttleInterval: .seconds(2.0),
-                                 debounceInterval: .seconds(1.0),
-                                 scheduler: DispatchQueue.main)
-            .sink { [unowned self] tuple, _ in
-                Task(priority: .high) {
-                    try await self.saveNewCGImageOnDisk(fileName: tuple.fileName, cgImage: tuple.cgImage)
-                }
+        layoutChangedSubject
+            .handleEvents(receiveOutput: { [unowned self] in
+                self.colorSamplingService.invalidate()
+            })
+            .debounce(for: .seconds(0.3), scheduler: DispatchQueue.main)
+            .sink { [unowned self] in
+                guard self.currentColorPickerType != nil else { return }
+                self.refreshColorSamplingCache()
             }
             .store(in: &cancellables)
     }
 
-    func performColorPickedAction(_ colorPickerType: ColorPickerType, _ throttleAndDebounceType: ThrottleAndDebounceType) {
+    func refreshColorSamplingCache() {
+        guard let framePixelWidth = projectModel.framePixelWidth,
+              let framePixelHeight = projectModel.framePixelHeight,
+              let frameRect = frame.rect else { return }
+
+        let framePixelSize = CGSize(width: framePixelWidth, height: framePixelHeight)
+
+        renderScheduler.schedule(.commit, key: "colorSampling") { [weak self] in
+            guard let self else { return }
+            let composite = try await self.photoExporterService.exportLayersToImage(
+                photos: self.projectLayers,
+                contextPixelSize: framePixelSize,
+                projectBackgroundColor: self.projectModel.backgroundColor.cgColor,
+                renderScale: self.colorSamplingService.renderScale(for: framePixelSize))
+
+            try Task.checkCancellation()
+            try await self.colorSamplingService.update(with: composite, covering: frameRect)
+        }
+    }
+
+    func sampleProjectColor(at planePoint: CGPoint) {
+        guard let currentColorPickerType,
+              let color = colorSamplingService.color(at: planePoint, sampleSize: colorSampleSize)
+        else { return }
+
+        currentShapeStyleModel = ShapeStyleModel(shapeStyle: color, shapeStyleCG: color.cgColor)
+        performColorPickedAction(currentColorPickerType)
+        isColorSamplingActive = false
+    }
+
+    // Frame events only render, the settle event only commits.
+    func performColorPickedAction(_ colorPickerType: ColorPickerType, _ phase: GestureEventPhaseType) {
         switch colorPickerType {
         case .projectBackground:
-            updateLatestSnapshot()
+            if phase == .settle {
+                updateLatestSnapshot()
+            }
         case .layerBackground:
-            Task {
-                try await addBackgroundToLayer()
+            if phase == .frame {
+                renderScheduler.schedule(.interactivePreview, key: "layerBackground") { [weak self] in
+                    try await self?.addBackgroundToLayer()
+                }
             }
         case .textColor, .borderColor:
-            if throttleAndDebounceType == .debounce {
+            if phase == .frame {
+                scheduleTextLayerRender()
+            } else {
                 updateLatestSnapshot()
-                Task {
-                    try await renderTextLayer()
-                }
+                persistTextLayer()
             }
-            objectWillChange.send()
         case .pencilColor:
             break
         case .bucketColorPicker:
@@ -273,7 +359,31 @@ final class ImageProjectViewModel: ObservableObject {
         objectWillChange.send()
     }
 
+    // A discrete pick is a single-event gesture, so text is rendered and saved in one pass.
+    func performColorPickedAction(_ colorPickerType: ColorPickerType) {
+        switch colorPickerType {
+        case .textColor, .borderColor:
+            updateLatestSnapshot()
+            scheduleTextLayerRender(isSavingToDisk: true)
+            objectWillChange.send()
+        default:
+            performColorPickedAction(colorPickerType, .frame)
+            performColorPickedAction(colorPickerType, .settle)
+        }
+    }
+
+    func layerSnappingIndex(excluding layer: LayerModel) -> LayerSnappingIndex {
+        if let cachedLayerSnappingIndex, cachedLayerSnappingIndex.excludedLayerId == layer.id {
+            return cachedLayerSnappingIndex
+        }
+
+        let layerSnappingIndex = LayerSnappingIndex(layers: projectLayers, excluding: layer)
+        cachedLayerSnappingIndex = layerSnappingIndex
+        return layerSnappingIndex
+    }
+
     func updateLatestSnapshot() {
+        cachedLayerSnappingIndex = nil
         if currentRevertModel.undoModel.count > undoLimit {
             currentRevertModel.undoModel.removeFirst()
         }
@@ -281,9 +391,10 @@ final class ImageProjectViewModel: ObservableObject {
         currentRevertModel.redoModel.removeAll()
         currentRevertModel.undoModel.append(currentRevertModel.latestSnapshot)
         currentRevertModel.latestSnapshot = createSnapshot()
+        removeUnreachableCheckpoints()
         projectModel.lastEditDate = Date.now
         if currentRevertModelType == .normal {
-            PersistenceController.shared.saveChanges()
+            PersistenceController.shared.scheduleSave()
             layoutChangedSubject.send()
         }
         objectWillChange.send()
@@ -321,13 +432,13 @@ final class ImageProjectViewModel: ObservableObject {
                          magicWandModel: magicWandModel)
         } else if currentRevertModelType == .magicWand {
             let layers = projectLayers.map { [unowned self] layer in
-                layer.copy(withCGImage: self.isInNewCGImagePreview) as! LayerModel
+                layer.snapshotCopy(withCGImage: self.isInNewCGImagePreview)
             }
 
             return .init(layers: layers, projectModel: projectModel, drawings: drawings, currentDrawing: currentDrawing, cropModel: cropModel, magicWandModel: magicWandModel)
         } else {
             let layers = projectLayers.map { [unowned self] layer in
-                layer.copy(withCGImage: !self.isInNewCGImagePreview) as! LayerModel
+                layer.snapshotCopy(withCGImage: !self.isInNewCGImagePreview)
             }
             let projectModel = projectModel.copy() as! ImageProjectModel
 
@@ -335,15 +446,136 @@ final class ImageProjectViewModel: ObservableObject {
         }
     }
 
-    nonisolated func saveNewCGImageOnDisk(fileName: String, cgImage: CGImage?) async throws {
+    nonisolated func saveNewCGImageOnDisk(fileName: String,
+                                          cgImage: CGImage?,
+                                          folderName: String = "UserMedia") async throws
+    {
+        try await Self.saveCGImage(cgImage, fileName: fileName, folderName: folderName, using: photoLibraryService)
+    }
+
+    // The write captures only the image and the service, never the view model.
+    func schedulePersistence(of cgImage: CGImage?,
+                             fileName: String,
+                             folderName: String = "UserMedia",
+                             key: String? = nil)
+    {
+        let photoLibraryService = photoLibraryService
+
+        RenderSchedulerService.persistence.schedule(.persistence, key: key) {
+            try await Self.saveCGImage(cgImage, fileName: fileName, folderName: folderName, using: photoLibraryService)
+        }
+    }
+
+    private nonisolated static func saveCGImage(_ cgImage: CGImage?,
+                                                fileName: String,
+                                                folderName: String,
+                                                using photoLibraryService: PhotoLibraryService) async throws
+    {
         guard let cgImage else { return }
         if let imageData = UIImage(cgImage: cgImage).pngData() {
             _ = try await photoLibraryService.saveToDisk(
                 data: imageData,
+                folderName: folderName,
                 fileName: fileName)
         }
     }
 
+    // Filters are committed as metadata only; the rendered result seeds the render graph cache.
+    func commitFilter(_ filter: FilterType) {
+        guard let activeLayer, let cgImage = activeLayer.cgImage else { return }
+
+        let truncatedOperations = activeLayer.editStack.append(.filter(filter))
+        activeLayer.committedCGImage = cgImage
+        editStackRenderService.store(cgImage, for: activeLayer.fileName, editStack: activeLayer.editStack)
+        discardCheckpoints(in: truncatedOperations, of: activeLayer)
+    }
+
+    func commitCheckpoint(of layer: LayerModel) {
+        guard let cgImage = layer.cgImage, cgImage !== layer.committedCGImage else { return }
+
+        let checkpointFileName = layer.photoEntity.checkpointFileNamePrefix + UUID().uuidString + ".PNG"
+        let checkpointsFolderName = layer.photoEntity.checkpointsDirectoryURL.lastPathComponent
+
+        let truncatedOperations = layer.editStack.append(.checkpoint(fileName: checkpointFileName))
+        layer.committedCGImage = cgImage
+        layer.removeOriginalFile()
+        editStackRenderService.store(cgImage, for: layer.fileName, editStack: layer.editStack)
+
+        schedulePersistence(of: cgImage,
+                            fileName: checkpointFileName,
+                            folderName: checkpointsFolderName,
+                            key: checkpointFileName)
+        discardCheckpoints(in: truncatedOperations, of: layer)
+    }
+
+    private func discardCheckpoints(in operations: [EditOperation], of layer: LayerModel) {
+        for case .checkpoint(let fileName) in operations {
+            discardedCheckpointFilePaths[fileName] = layer.photoEntity.absoluteCheckpointFilePath(fileName: fileName)
+        }
+        removeUnreachableCheckpoints()
+    }
+
+    // Undo snapshots keep the edit stacks they were taken with, so a dropped checkpoint is only
+    // removed once neither the layers nor any snapshot can replay it.
+    private func removeUnreachableCheckpoints() {
+        guard !discardedCheckpointFilePaths.isEmpty else { return }
+
+        let snapshots = revertModels.values.flatMap { revertModel in
+            revertModel.undoModel + revertModel.redoModel + [revertModel.latestSnapshot].compactMap { $0 }
+        }
+        let reachableFileNames = Set((projectLayers + snapshots.flatMap(\.layers))
+            .flatMap(\.editStack.checkpointFileNames))
+
+        let unreachableFileNames = discardedCheckpointFilePaths.keys.filter { !reachableFileNames.contains($0) }
+        for fileName in unreachableFileNames {
+            guard let filePath = discardedCheckpointFilePaths.removeValue(forKey: fileName) else { continue }
+
+            // Shares the write's key: a queued write is dropped, a running one finishes before the removal starts.
+            RenderSchedulerService.persistence.schedule(.persistence, key: fileName) {
+                try? FileManager.default.removeItem(atPath: filePath)
+            }
+        }
+    }
+
+    func replayEditStack(of layer: LayerModel) async {
+        let editStack = layer.editStack
+
+        let precision = projectModel.pixelPrecision
+
+        do {
+            guard let cgImage = try await renderScheduler.perform(.commit, key: "replay-\(layer.fileName)", operation: {
+                try await self.editStackRenderService.render(editStack, of: layer, precision: precision)
+            }),
+                layer.editStack == editStack
+            else { return }
+
+            layer.cgImage = cgImage
+            layer.committedCGImage = cgImage
+            objectWillChange.send()
+        } catch is CancellationError {
+            return
+        } catch {
+            print(error)
+        }
+    }
+
+    // Text is re-rendered from the restored attributes, other layers are replayed from their edit stack.
+    private func restoreLayerImage(of layer: LayerModel, isSnapshotImageLoaded: Bool) {
+        if let textLayer = layer as? TextLayerModel {
+            if isSnapshotImageLoaded {
+                schedulePersistence(of: textLayer.cgImage, fileName: textLayer.fileName, key: "save-\(textLayer.fileName)")
+            } else {
+                renderScheduler.schedule(.commit, key: "restoreText-\(textLayer.fileName)") { [weak self] in
+                    try await self?.renderTextLayer(textLayer: textLayer)
+                }
+            }
+        } else if layer.committedCGImage == nil {
+            Task { [unowned self] in
+                await self.replayEditStack(of: layer)
+            }
+        }
+    }
+
     private func loadPreviousProjectLayerData(isUndo: Bool) {
         let previousSnapshots = (isUndo
             ? currentRevertModel.undoModel
@@ -368,14 +600,13 @@ final class ImageProjectViewModel: ObservableObject {
             if let layer = projectLayers.first(where: { $0.fileName == previousLayer.fileName }) {
                 layer.positionZ = previousLayer.positionZ
                 layer.toDelete = previousLayer.toDelete
+                layer.blendMode = previousLayer.blendMode
+                layer.opacity = previousLayer.opacity
 
-                layer.cgImage = previousLayer.cgImage
+                layer.editStack = previousLayer.editStack
+                let isSnapshotImageLoaded = layer.loadSnapshotImages(from: previousLayer)
 
-                Task(priority: .high) { [unowned self] in
-                    try await self.saveNewCGImageOnDisk(
-                        fileName: previousLayer.fileName,
-                        cgImage: previousLayer.cgImage)
-                }
+                restoreLayerImage(of: layer, isSnapshotImageLoaded: isSnapshotImageLoaded)
 
                 let distanceDiff = hypot(layer.position!.x - previousLayer.position!.x,
                                          layer.position!.y - previousLayer.position!.y)
@@ -388,7 +619,7 @@ final class ImageProjectViewModel: ObservableObject {
                     layer.rotation = previousLayer.rotation
                     layer.scaleX = previousLayer.scaleX
                     layer.scaleY = previousLayer.scaleY
-                    layer.size = self.calculateLayerSize(layerModel: previousLayer)
+                    layer.size = self.calculateLayerSize(layerModel: layer)
                 }
 
                 if let previousTextLayer = previousLayer as? TextLayerModel,
@@ -404,7 +635,10 @@ final class ImageProjectViewModel: ObservableObject {
                 }
 
             } else {
+                let isSnapshotImageLoaded = previousLayer.loadSnapshotImages(from: previousLayer)
                 projectLayers.append(previousLayer)
+
+                restoreLayerImage(of: previousLayer, isSnapshotImageLoaded: isSnapshotImageLoaded)
             }
         }
         let previousDrawings = previousSnapshot.drawings
@@ -431,8 +665,9 @@ final class ImageProjectViewModel: ObservableObject {
             recalculateFrameAndLayersGeometry()
         }
         projectModel.lastEditDate = Date.now
-        PersistenceController.shared.saveChanges()
+        PersistenceController.shared.scheduleSave()
         setupInitialColorPickerColor()
+        cachedLayerSnappingIndex = nil
         layoutChangedSubject.send()
     }
 
@@ -480,6 +715,8 @@ final class ImageProjectViewModel: ObservableObject {
         newLayer.scaleY = layer.scaleY
         newLayer.size = layer.size
         newLayer.toDelete = layer.toDelete
+        newLayer.blendMode = layer.blendMode
+        newLayer.opacity = layer.opacity
         newLayer.cgImage = layer.cgImage
 
         if let newTextLayer = newLayer as? TextLayerModel,
@@ -501,6 +738,12 @@ final class ImageProjectViewModel: ObservableObject {
         showLayerOnScreen(layerModel: newLayer)
     }
 
+    var mergedLayersBounds: CGRect? {
+        return layersToMerge
+            .compactMap { $0.worldBounds }
+            .reduce(nil) { union, bounds in union?.union(bounds) ?? bounds }
+    }
+
     func calculateBoundsForMergedLayers() -> (layerRect: CGRect?, pixelSize: CGSize?) {
         var minX, minY, maxX, maxY: Double?
 
@@ -510,24 +753,17 @@ final class ImageProjectViewModel: ObservableObject {
         var maxPixelToDigitalHeightRatio: CGFloat?
 
         for layer in layersToMerge {
-            let (topLeftX, topLeftY) = (layer.topLeftApexPosition().x * layer.pixelToDigitalWidthRatio,
-                                        layer.topLeftApexPosition().y * layer.pixelToDigitalHeightRatio)
-            let (topRightX, topRightY) = (layer.topRightApexPosition().x * layer.pixelToDigitalWidthRatio,
-                                          layer.topRightApexPosition().y * layer.pixelToDigitalHeightRatio)
-            let (bottomLeftX, bottomLeftY) = (layer.bottomLeftApexPosition().x * layer.pixelToDigitalWidthRatio,
-                                              layer.bottomLeftApexPosition().y * layer.pixelToDigitalHeightRatio)
-            let (bottomRightX, bottomRightY) = (layer.bottomRightApexPosition().x * layer.pixelToDigitalWidthRatio,
-                                                layer.bottomRightApexPosition().y * layer.pixelToDigitalHeightRatio)
+            guard let worldBounds = layer.worldBounds else { continue }
 
             let prevMinX = minX
             let prevMinY = minY
             let prevMaxX = maxX
             let prevMaxY = maxY
 
-            minX = min(minX ?? Double(Int.max), topLeftX, topRightX, bottomLeftX, bottomRightX)
-            minY = min(minY ?? Double(Int.max), topLeftY, topRightY, bottomLeftY, bottomRightY)
-            maxX = max(maxX ?? Double(Int.min), topLeftX, topRightX, bottomLeftX, bottomRightX)
-            maxY = max(maxY ?? Double(Int.min), topLeftY, topRightY, bottomLeftY, bottomRightY)
+            minX = min(minX ?? Double(Int.max), worldBounds.minX * layer.pixelToDigitalWidthRatio)
+            minY = min(minY ?? Double(Int.max), worldBounds.minY * layer.pixelToDigitalHeightRatio)
+            maxX = max(maxX ?? Double(Int.min), worldBounds.maxX * layer.pixelToDigitalWidthRatio)
+            maxY = max(maxY ?? Double(Int.min), worldBounds.maxY * layer.pixelToDigitalHeightRatio)
 
             if prevMinX != minX {
                 minPixelToDigitalWidthRatio = layer.pixelToDigitalWidthRatio
@@ -578,6 +814,11 @@ final class ImageProjectViewModel: ObservableObject {
         }
     }
 
+    func hitTestLayer(at point: CGPoint) -> LayerModel? {
+        layerHitTestIndex.sync(with: projectLayers)
+        return layerHitTestIndex.topmostLayer(at: point, alphaThreshold: layerHitTestAlphaThreshold)
+    }
+
     func toggleToMergeStatus(layerModel: LayerModel) {
         if layersToMerge.contains(layerModel) {
             layersToMerge.removeAll { $0.fileName == layerModel.fileName }
@@ -602,22 +843,26 @@ final class ImageProjectViewModel: ObservableObject {
                     mergedLayerBounds.width,
                     y: -mergedLayerBounds.midY *
                         mergedLayersPixelSize.height /
-                        mergedLayerBounds.height))
+                        mergedLayerBounds.height),
+                precision: projectModel.pixelPrecision)
 
         let mergedLayerFileName = UUID().uuidString + ".PNG"
         try await saveNewCGImageOnDisk(fileName: mergedLayerFileName, cgImage: mergedCGImage)
 
-        let newEntity = PhotoEntity(fileName: mergedLayerFileName, projectEntity: projectModel.imageProjectEntity)
-        let mergedLayerModel = LayerModel(photoEntity: newEntity)
-        newEntity.photoEntityToImageProjectEntity = projectModel.imageProjectEntity
+        // The new entity and the deletion flags of every merged layer are saved together.
+        PersistenceController.shared.performTransaction {
+            let newEntity = PhotoEntity(fileName: mergedLayerFileName, projectEntity: projectModel.imageProjectEntity)
+            let mergedLayerModel = LayerModel(photoEntity: newEntity)
+            newEntity.photoEntityToImageProjectEntity = projectModel.imageProjectEntity
 
-        mergedLayerModel.position = CGPoint(x: mergedLayerBounds.midX, y: mergedLayerBounds.midY)
+            mergedLayerModel.position = CGPoint(x: mergedLayerBounds.midX, y: mergedLayerBounds.midY)
 
-        cleanupAfterMerge()
+            cleanupAfterMerge()
 
-        projectLayers.append(mergedLayerModel)
+            projectLayers.append(mergedLayerModel)
 
-        showLayerOnScreen(layerModel: mergedLayerModel)
+            showLayerOnScreen(layerModel: mergedLayerModel)
+        }
     }
 
     func addBackgroundToLayer() async throws {
@@ -629,7 +874,8 @@ final class ImageProjectViewModel: ObservableObject {
                 photos: [activeLayer],
                 contextPixelSize: activeLayer.pixelSize,
                 layerBackgroundShapeStyle: currentShapeStyleModel,
-                isApplyingTransforms: false)
+                isApplyingTransforms: false,
+                precision: projectModel.pixelPrecision)
 
         activeLayer.cgImage = layerWithBackground
         objectWillChange.send()
@@ -676,22 +922,20 @@ final class ImageProjectViewModel: ObservableObject {
                                   cropPath: path,
                                   shapePoints: shapePoints)
 
-        try await saveNewCGImageOnDisk(fileName: activeLayer.fileName, cgImage: croppedCGImage)
-
         withAnimation {
             activeLayer.cgImage = croppedCGImage
             activeLayer.size = calculateLayerSize(layerModel: activeLayer)
         }
 
+        commitCheckpoint(of: activeLayer)
+
         objectWillChange.send()
     }
 
     func deactivateLayer() {
         disablePreviewCGImage()
-        if let activeLayer {
-            Task {
-                try await saveNewCGImageOnDisk(fileName: activeLayer.fileName, cgImage: activeLayer.cgImage)
-            }
+        if let activeLayer, activeLayer.committedCGImage != nil, !(activeLayer is TextLayerModel) {
+            commitCheckpoint(of: activeLayer)
         }
         activeLayer = nil
         currentCategory = nil
@@ -920,42 +1164,62 @@ final class ImageProjectViewModel: ObservableObject {
         guard let framePixelWidth = projectModel.framePixelWidth,
               let framePixelHeight = projectModel.framePixelHeight,
               let marginedWorkspaceWidth = marginedWorkspaceSize?.width else { return }
+        let projectLayers = projectLayers
+        let backgroundColor = projectModel.backgroundColor.cgColor
+        let thumbnailFolderName = projectModel.imageProjectThumbnailFolderName
+        let thumbnailFileName = projectModel.id!.uuidString
+
         do {
-            let renderedPhoto = try await photoExporterService.exportLayersToImage(
-                photos: projectLayers,
-                contextPixelSize: CGSize(width: framePixelWidth, height: framePixelHeight),
-                projectBackgroundColor: projectModel.backgroundColor.cgColor)
-
-            let resizedPhoto = try await photoExporterService.resizePhoto(
-                renderedPhoto: renderedPhoto,
-                renderSize: .preview,
-                photoFormat: .jpeg,
-                framePixelWidth: framePixelWidth,
-                framePixelHeight: framePixelHeight,
-                marginedWorkspaceWidth: marginedWorkspaceWidth)
-
-            guard let imageData = UIImage(cgImage: resizedPhoto).pngData() else {
-                throw PhotoExportError.dataRetrieving
-            }
+            try await renderScheduler.perform(.thumbnail, key: "thumbnail") { [unowned self] in
+                let renderedPhoto = try await self.photoExporterService.exportLayersToImage(
+                    photos: projectLayers,
+                    contextPixelSize: CGSize(width: framePixelWidth, height: framePixelHeight),
+                    projectBackgroundColor: backgroundColor)
+
+                let resizedPhoto = try await self.photoExporterService.resizePhoto(
+                    renderedPhoto: renderedPhoto,
+                    renderSize: .preview,
+                    photoFormat: .jpeg,
+                    framePixelWidth: framePixelWidth,
+                    framePixelHeight: framePixelHeight,
+                    marginedWorkspaceWidth: marginedWorkspaceWidth)
+
+                guard let imageData = UIImage(cgImage: resizedPhoto).pngData() else {
+                    throw PhotoExportError.dataRetrieving
+                }
 
-            _ = try await photoLibraryService.saveToDisk(
-                data: imageData,
-                extension: "JPEG",
-                folderName: projectModel.imageProjectThumbnailFolderName,
-                fileName: projectModel.id!.uuidString)
+                _ = try await self.photoLibraryService.saveToDisk(
+                    data: imageData,
+                    extension: "JPEG",
+                    folderName: thumbnailFolderName,
+                    fileName: thumbnailFileName)
+            }
+        } catch is CancellationError {
+            return
         } catch {
             print(error)
         }
     }
 
     func addAssetsToProject() async throws {
-        let fileNames = try await photoLibraryService.saveAssetsAndGetFileNames(assets: selectedPhotos)
-        try projectModel.insertPhotosEntityToProject(fileNames: fileNames)
+        var importOptions = PhotoImportOptions()
+        importOptions.proxySize = .original
+
+        if isDownsamplingImports,
+           let framePixelWidth = projectModel.framePixelWidth,
+           let framePixelHeight = projectModel.framePixelHeight
+        {
+            importOptions.workingMaxPixelSize = Int(max(framePixelWidth, framePixelHeight))
+        }
+
+        let importResults = try await photoLibraryService.importAssets(selectedPhotos, options: importOptions)
+        try projectModel.insertPhotosEntityToProject(fileNames: importResults.map(\.fileName))
 
         for photoEntity in projectModel.photoEntities
             where !projectLayers.contains(where: { $0.fileName == photoEntity.fileName })
         {
-            projectLayers.append(LayerModel(photoEntity: photoEntity))
+            let proxy = importResults.first(where: { $0.fileName == photoEntity.fileName })?.proxy
+            projectLayers.append(LayerModel(photoEntity: photoEntity, cgImage: proxy))
         }
     }
 
@@ -981,13 +1245,29 @@ final class ImageProjectViewModel: ObservableObject {
         return textLayerModel
     }
 
-    func renderTextLayer(textLayer: TextLayerModel? = nil) async throws {
+    func scheduleTextLayerRender(isSavingToDisk: Bool = false) {
+        renderScheduler.schedule(.interactivePreview, key: "textLayer") { [weak self] in
+            try await self?.renderTextLayer(isSavingToDisk: isSavingToDisk)
+        }
+    }
+
+    func persistTextLayer() {
+        guard let textLayerModel = activeLayer as? TextLayerModel else { return }
+
+        schedulePersistence(of: textLayerModel.cgImage,
+                            fileName: textLayerModel.fileName,
+                            key: "save-\(textLayerModel.fileName)")
+    }
+
+    func renderTextLayer(textLayer: TextLayerModel? = nil, isSavingToDisk: Bool = true) async throws {
         let textLayerModel = textLayer ?? activeLayer as? TextLayerModel ?? nil
         guard let textLayerModel else { return }
         do {
             let textCGImage = try await photoExporterService.renderTextLayer(textModelEntity: textLayerModel.textModelEntity)
 
-            try await saveNewCGImageOnDisk(fileName: textLayerModel.fileName, cgImage: textCGImage)
+            if isSavingToDisk {
+                try await saveNewCGImageOnDisk(fileName: textLayerModel.fileName, cgImage: textCGImage)
+            }
             textLayerModel.cgImage = textCGImage
             textLayerModel.size = calculateLayerSize(layerModel: textLayerModel)
         } catch {
@@ -998,23 +1278,20 @@ final class ImageProjectViewModel: ObservableObject {
     func applyFilter() async {
         guard let activeLayer,
               let currentFilter else { return }
-        let cgImage = await Task<CGImage?, Never> { [unowned self] in
-            let ciImage = CIImage(cgImage: self.originalCGImage.copy()!)
-
-            let filter = currentFilter.createFilter(image: ciImage)
-
-            guard let outputImage = filter.outputImage?.cropped(to: ciImage.extent) else { return nil }
-
-            let context = CIContext()
 
-            let newExtent = ciImage.extent.insetBy(dx: -outputImage.extent.origin.x * 0.5,
-                                                   dy: -outputImage.extent.origin.y * 0.5)
-            guard let cgImage = context.createCGImage(outputImage, from: newExtent) else { return nil }
+        let sourceImage: CGImage = self.originalCGImage
+        let precision = projectModel.pixelPrecision
 
-            return cgImage
-        }.value
-
-        activeLayer.cgImage = cgImage
+        do {
+            activeLayer.cgImage = try await renderScheduler.perform(.interactivePreview, key: "filterPreview") {
+                try await self.editStackRenderService.applyFilter(currentFilter, to: sourceImage, precision: precision)
+            }
+        } catch is CancellationError {
+            return
+        } catch {
+            print(error)
+            activeLayer.cgImage = nil
+        }
 
         objectWillChange.send()
     }
@@ -1023,19 +1300,29 @@ final class ImageProjectViewModel: ObservableObject {
         guard let framePixelWidth = projectModel.framePixelWidth,
               let framePixelHeight = projectModel.framePixelHeight,
               let marginedWorkspaceWidth = marginedWorkspaceSize?.width else { return }
+        let projectLayers = projectLayers
+        let backgroundColor = projectModel.backgroundColor.cgColor
+        let precision = projectModel.pixelPrecision
+
         do {
-            let renderedPhoto = try await photoExporterService.exportLayersToImage(
-                photos: projectLayers,
-                contextPixelSize: CGSize(width: framePixelWidth, height: framePixelHeight),
-                projectBackgroundColor: projectModel.backgroundColor.cgColor)
-
-            let resizedPhoto = try await photoExporterService.resizePhoto(
-                renderedPhoto: renderedPhoto,
-                renderSize: renderSize,
-                photoFormat: photoFormat,
-                framePixelWidth: framePixelWidth,
-                framePixelHeight: framePixelHeight,
-                marginedWorkspaceWidth: marginedWorkspaceWidth)
+            let resizedPhoto = try await renderScheduler.perform(renderSize == .preview ? .interactivePreview : .commit,
+                                                                 key: "renderPhoto-\(renderSize)")
+            { [unowned self] in
+                let renderedPhoto = try await self.photoExporterService.exportLayersToImage(
+                    photos: projectLayers,
+                    contextPixelSize: CGSize(width: framePixelWidth, height: framePixelHeight),
+                    projectBackgroundColor: backgroundColor,
+                    isUsingOriginals: renderSize != .preview,
+                    precision: precision)
+
+                return try await self.photoExporterService.resizePhoto(
+                    renderedPhoto: renderedPhoto,
+                    renderSize: renderSize,
+                    photoFormat: photoFormat,
+                    framePixelWidth: framePixelWidth,
+                    framePixelHeight: framePixelHeight,
+                    marginedWorkspaceWidth: marginedWorkspaceWidth)
+            }
 
             if renderSize == .preview {
                 previewPhoto = resizedPhoto
@@ -1053,6 +1340,8 @@ final class ImageProjectViewModel: ObservableObject {
                 isExportSheetPresented = false
             }
 
+        } catch is CancellationError {
+            return
         } catch {
             if renderSize != .preview {
                 isExportSheetPresented = false
@@ -1062,22 +1351,45 @@ final class ImageProjectViewModel: ObservableObject {
         }
     }
 
+    func rasterizeDrawings(frameSize: CGSize) {
+        guard let activeLayer,
+              let layerImage = activeLayer.cgImage,
+              let layerScaleX = activeLayer.scaleX,
+              let layerScaleY = activeLayer.scaleY else { return }
+        if strokeRasterizer?.baseImage !== layerImage || strokeRasterizer?.frameSize != frameSize {
+            strokeRasterizer = StrokeRasterizerService(baseImage: layerImage,
+                                                       frameSize: frameSize,
+                                                       scaleX: layerScaleX,
+                                                       scaleY: layerScaleY)
+        }
+        strokeRasterizer?.update(drawings: drawings, currentDrawing: currentDrawing)
+    }
+
     func applyDrawings(frameSize: CGSize) async {
         guard let activeLayer else { return }
+        defer { strokeRasterizer = nil }
         do {
-            let newCGImage = try await
-                photoExporterService
-                .renderImageFromDrawings(
-                    from: drawings,
-                    on: activeLayer,
-                    frameSize: frameSize,
-                    pixelFrameSize: activeLayer.pixelSize)
+            let newCGImage: CGImage
+            if let strokeRasterizer,
+               strokeRasterizer.baseImage === activeLayer.cgImage,
+               strokeRasterizer.frameSize == frameSize,
+               let rasterizedImage = try? await strokeRasterizer.makeImage(from: drawings)
+            {
+                newCGImage = rasterizedImage
+            } else {
+                newCGImage = try await
+                    photoExporterService
+                    .renderImageFromDrawings(
+                        from: drawings,
+                        on: activeLayer,
+                        frameSize: frameSize,
+                        pixelFrameSize: activeLayer.pixelSize)
+            }
 
             activeLayer.cgImage = newCGImage
+            commitCheckpoint(of: activeLayer)
             drawings.removeAll()
             updateLatestSnapshot()
-            saveLayerImageSubject.send((activeLayer.fileName,
-                                        newCGImage))
 
         } catch {
             print(error)
@@ -1093,17 +1405,32 @@ final class ImageProjectViewModel: ObservableObject {
         revertModels[revertModelType] = nil
     }
 
+    func appendDrawingParticle(_ position: CGPoint, frameSize: CGSize) {
+        let tolerance: CGFloat = {
+            guard currentDrawing.isSmoothed, let activeLayer, frameSize.width > 0.0 else { return 0.0 }
+            return StrokePointStream.tolerance(pixelsPerPoint: activeLayer.pixelSize.width / frameSize.width,
+                                               displayScale: UIScreen.main.scale)
+        }()
+
+        currentDrawing.stroke.append(position, tolerance: tolerance)
+        rasterizeDrawings(frameSize: frameSize)
+    }
+
     func storeCurrentDrawing() {
-        drawings.append(currentDrawing)
+        var finishedDrawing = currentDrawing
+        finishedDrawing.stroke.finish()
+        drawings.append(finishedDrawing)
         currentDrawing = DrawingModel(currentPencilType: currentDrawing.currentPencilType,
                                       currentPencilSize: currentDrawing.currentPencilSize,
-                                      currentPencilStyle: currentDrawing.currentPencilStyle,
-                                      particlesPositions: [])
+                                      currentPencilStyle: currentDrawing.currentPencilStyle)
         updateLatestSnapshot()
     }
 
     func setupInitialColorPickerColor() {
         guard let currentColorPickerType else { return }
+        if currentColorPickerType.allowsProjectSampling, colorSamplingService.isStale {
+            refreshColorSamplingCache()
+        }
         let color: Color? = {
             switch currentColorPickerType {
             case .projectBackground:
@@ -1134,7 +1461,7 @@ final class ImageProjectViewModel: ObservableObject {
 
     func setupRightButtonActionForPen() {
         guard currentDrawing.currentPencilType != .pen ||
-            currentDrawing.particlesPositions.isEmpty
+            currentDrawing.stroke.isEmpty
         else {
             rightFloatingButtonActionType = .endPenPath
             tools.rightFloatingButtonIcon = "pencil.line"
@@ -1151,7 +1478,7 @@ final class ImageProjectViewModel: ObservableObject {
     func endPenPath() {
         rightFloatingButtonActionType = .confirm
         tools.rightFloatingButtonIcon = "checkmark"
-        if !currentDrawing.particlesPositions.isEmpty {
+        if !currentDrawing.stroke.isEmpty {
             storeCurrentDrawing()
         }
     }
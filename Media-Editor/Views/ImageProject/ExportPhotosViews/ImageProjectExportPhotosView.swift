@@ -54,6 +54,18 @@ struct ImageProjectExportPhotosView: View {
                     Text("Render Size")
                         .foregroundStyle(Color(.tint))
                 }
+                Section {
+                    Picker("Precision", selection: $vm.projectModel.pixelPrecision) {
+                        ForEach(PixelPrecisionType.allCases, id: \.self) { precisionType in
+                            Text(precisionType.toString)
+                        }
+                    }
+                    .padding(.vertical, 8.0)
+                    .pickerStyle(.segmented)
+                } header: {
+                    Text("Working Precision")
+                        .foregroundStyle(Color(.tint))
+                }
                 Section {
                     Button {
                         Task {
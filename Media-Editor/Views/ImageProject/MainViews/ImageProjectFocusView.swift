@@ -68,11 +68,7 @@ struct ImageProjectFocusView: View {
                     if action == .confirm {
                         vm.currentTool = .none
                         vm.currentColorPickerType = .none
-                        Task {
-                            try await vm.saveNewCGImageOnDisk(
-                                fileName: layerModel.fileName,
-                                cgImage: layerModel.cgImage)
-                        }
+                        vm.commitCheckpoint(of: layerModel)
                         vm.leftFloatingButtonActionType = .back
                         vm.updateLatestSnapshot()
 
@@ -52,192 +52,56 @@ extension ImageProjectLayerView {
         var touchPositionX: CGFloat?
         var touchPositionY: CGFloat?
 
-        for otherLayer in vm.projectLayers
-            where (otherLayer.positionZ ?? 0) > 0 && otherLayer != layerModel
-        {
-            guard let otherLayerPosition = otherLayer.position,
-                  let otherLayerRotation = otherLayer.rotation,
-                  let otherLayerSize = otherLayer.size,
-                  let otherLayerScaleX = otherLayer.scaleX,
-                  let otherLayerScaleY = otherLayer.scaleY
-            else { return }
-
-            guard draggedLayerRotation.isRightAngle, otherLayerRotation.isRightAngle else { continue }
-
-            let otherLayerTopLeftApexPosition =
-                otherLayer.rotatedApexPositionFunction(apex: .topLeft)(nil)
-            let otherLayerTopRightApexPosition =
-                otherLayer.rotatedApexPositionFunction(apex: .topRight)(nil)
-            let otherLayerBottomLeftApexPosition =
-                otherLayer.rotatedApexPositionFunction(apex: .bottomLeft)(nil)
-            let otherLayerBottomRightApexPosition =
-                otherLayer.rotatedApexPositionFunction(apex: .bottomRight)(nil)
-
-            let otherLayerWidth = otherLayerSize.width * abs(otherLayerScaleX)
-            let otherLayerHeight = otherLayerSize.height * abs(otherLayerScaleY)
-            let draggedLayerWidth = draggedLayerSize.width * abs(draggedLayerScaleX)
-            let draggedLayerHeight = draggedLayerSize.height * abs(draggedLayerScaleY)
-
-//                     trailing - leading
-            if abs(draggedLayerTopRightApexPosition.x - otherLayerBottomLeftApexPosition.x)
-                < dragGestureTolerance
-            {
-                let draggedLayerComponent = 0.0
-                    - draggedLayerWidth * 0.5 * cos(draggedLayerRotation.radians)
-                    * (draggedLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-                    + draggedLayerHeight * 0.5 * sin(draggedLayerRotation.radians)
-                    * (draggedLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-
-                let otherLayerComponent = otherLayerPosition.x
-                    - otherLayerWidth * 0.5 * cos(otherLayerRotation.radians)
-                    * (otherLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-                    + otherLayerHeight * 0.5 * sin(otherLayerRotation.radians)
-                    * (otherLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-
-                newX = draggedLayerComponent + otherLayerComponent
-                touchPositionX = otherLayerBottomLeftApexPosition.x
-                isXChanged = true
-            }
-//                      trailing - trailing
-            else if abs(draggedLayerTopRightApexPosition.x - otherLayerTopRightApexPosition.x)
-                < dragGestureTolerance
-            {
-                let draggedLayerComponent = 0.0
-                    - draggedLayerWidth * 0.5 * cos(draggedLayerRotation.radians)
-                    * (draggedLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-                    + draggedLayerHeight * 0.5 * sin(draggedLayerRotation.radians)
-                    * (draggedLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-
-                let otherLayerComponent = otherLayerPosition.x
-                    + otherLayerWidth * 0.5 * cos(otherLayerRotation.radians)
-                    * (otherLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-                    - otherLayerHeight * 0.5 * sin(otherLayerRotation.radians)
-                    * (otherLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-
-                newX = draggedLayerComponent + otherLayerComponent
-                touchPositionX = otherLayerTopRightApexPosition.x
-                isXChanged = true
-            }
-            // leading - leading
-            else if abs(draggedLayerBottomLeftApexPosition.x - otherLayerBottomLeftApexPosition.x)
-                < dragGestureTolerance
-            {
-                let draggedLayerComponent = 0.0
-                    + draggedLayerWidth * 0.5 * cos(draggedLayerRotation.radians)
-                    * (draggedLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-                    - draggedLayerHeight * 0.5 * sin(draggedLayerRotation.radians)
-                    * (draggedLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-
-                let otherLayerComponent = otherLayerPosition.x
-                    - otherLayerWidth * 0.5 * cos(otherLayerRotation.radians)
-                    * (otherLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-                    + otherLayerHeight * 0.5 * sin(otherLayerRotation.radians)
-                    * (otherLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-
-                newX = draggedLayerComponent + otherLayerComponent
-                touchPositionX = otherLayerBottomLeftApexPosition.x
-                isXChanged = true
-            }
-            // leading - trailing
-            else if abs(draggedLayerBottomLeftApexPosition.x - otherLayerTopRightApexPosition.x)
-                < dragGestureTolerance
-            {
-                let draggedLayerComponent = 0.0
-                    + draggedLayerWidth * 0.5 * cos(draggedLayerRotation.radians)
-                    * (draggedLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-                    - draggedLayerHeight * 0.5 * sin(draggedLayerRotation.radians)
-                    * (draggedLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-
-                let otherLayerComponent = otherLayerPosition.x
-                    + otherLayerWidth * 0.5 * cos(otherLayerRotation.radians)
-                    * (otherLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-                    - otherLayerHeight * 0.5 * sin(otherLayerRotation.radians)
-                    * (otherLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-
-                newX = draggedLayerComponent + otherLayerComponent
-                touchPositionX = otherLayerTopRightApexPosition.x
-                isXChanged = true
-            }
-            // top - bottom
-            if abs(draggedLayerTopLeftApexPosition.y - otherLayerBottomRightApexPosition.y)
-                < dragGestureTolerance
-            {
-                let draggedLayerComponent = 0.0
-                    - draggedLayerWidth * 0.5 * sin(draggedLayerRotation.radians)
-                    * (draggedLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-                    + draggedLayerHeight * 0.5 * cos(draggedLayerRotation.radians)
-                    * (draggedLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-
-                let otherLayerComponent = otherLayerPosition.y
-                    - otherLayerWidth * 0.5 * sin(otherLayerRotation.radians)
-                    * (otherLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-                    + otherLayerHeight * 0.5 * cos(otherLayerRotation.radians)
-                    * (otherLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-
-                newY = draggedLayerComponent + otherLayerComponent
-                touchPositionY = otherLayerBottomRightApexPosition.y
-                isYChanged = true
-            }
-            // top - top
-            else if abs(draggedLayerTopLeftApexPosition.y - otherLayerTopLeftApexPosition.y)
-                < dragGestureTolerance
-            {
-                let draggedLayerComponent = 0.0
-                    - draggedLayerWidth * 0.5 * sin(draggedLayerRotation.radians)
-                    * (draggedLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-                    + draggedLayerHeight * 0.5 * cos(draggedLayerRotation.radians)
-                    * (draggedLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-
-                let otherLayerComponent = otherLayerPosition.y
-                    + otherLayerWidth * 0.5 * sin(otherLayerRotation.radians)
-                    * (otherLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-                    - otherLayerHeight * 0.5 * cos(otherLayerRotation.radians)
-                    * (otherLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-
-                newY = draggedLayerComponent + otherLayerComponent
-                touchPositionY = otherLayerTopLeftApexPosition.y
-                isYChanged = true
-            }
-            // bottom - bottom
-            else if abs(draggedLayerBottomRightApexPosition.y - otherLayerBottomRightApexPosition.y)
-                < dragGestureTolerance
-            {
-                let draggedLayerComponent = 0.0
-                    + draggedLayerWidth * 0.5 * sin(draggedLayerRotation.radians)
-                    * (draggedLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-                    - draggedLayerHeight * 0.5 * cos(draggedLayerRotation.radians)
-                    * (draggedLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-
-                let otherLayerComponent = otherLayerPosition.y
-                    - otherLayerWidth * 0.5 * sin(otherLayerRotation.radians)
-                    * (otherLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-                    + otherLayerHeight * 0.5 * cos(otherLayerRotation.radians)
-                    * (otherLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-
-                newY = draggedLayerComponent + otherLayerComponent
-                touchPositionY = otherLayerBottomRightApexPosition.y
-                isYChanged = true
-            }
-            // bottom - top
-            else if abs(draggedLayerBottomRightApexPosition.y - otherLayerTopLeftApexPosition.y)
-                < dragGestureTolerance
-            {
-                let draggedLayerComponent = 0.0
-                    + draggedLayerWidth * 0.5 * sin(draggedLayerRotation.radians)
-                    * (draggedLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-                    - draggedLayerHeight * 0.5 * cos(draggedLayerRotation.radians)
-                    * (draggedLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
+        let snappingIndex = vm.layerSnappingIndex(excluding: layerModel)
 
-                let otherLayerComponent = otherLayerPosition.y
-                    + otherLayerWidth * 0.5 * sin(otherLayerRotation.radians)
-                    * (otherLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
-                    - otherLayerHeight * 0.5 * cos(otherLayerRotation.radians)
-                    * (otherLayerRotation.isBelowHalfAngle ? -1.0 : 1.0)
+        if draggedLayerRotation.isRightAngle,
+           let otherLayerEdgeX = snappingIndex.nearestEdgeX(to: draggedLayerTopRightApexPosition.x,
+                                                           tolerance: dragGestureTolerance)
+        {
+            // trailing - leading, trailing - trailing
+            newX = otherLayerEdgeX - (draggedLayerTopRightApexPosition.x - newDraggedLayerPosition.x)
+            touchPositionX = otherLayerEdgeX
+            isXChanged = true
+        } else if draggedLayerRotation.isRightAngle,
+                  let otherLayerEdgeX = snappingIndex.nearestEdgeX(to: draggedLayerBottomLeftApexPosition.x,
+                                                                  tolerance: dragGestureTolerance)
+        {
+            // leading - leading, leading - trailing
+            newX = otherLayerEdgeX + (newDraggedLayerPosition.x - draggedLayerBottomLeftApexPosition.x)
+            touchPositionX = otherLayerEdgeX
+            isXChanged = true
+        } else if let otherLayerCenterX = snappingIndex.nearestCenterX(to: newDraggedLayerPosition.x,
+                                                                       tolerance: dragGestureTolerance)
+        {
+            // centerX - centerX
+            newX = otherLayerCenterX
+            touchPositionX = otherLayerCenterX
+            isXChanged = true
+        }
 
-                newY = draggedLayerComponent + otherLayerComponent
-                touchPositionY = otherLayerTopLeftApexPosition.y
-                isYChanged = true
-            }
+        if draggedLayerRotation.isRightAngle,
+           let otherLayerEdgeY = snappingIndex.nearestEdgeY(to: draggedLayerTopLeftApexPosition.y,
+                                                           tolerance: dragGestureTolerance)
+        {
+            // top - bottom, top - top
+            newY = otherLayerEdgeY + (newDraggedLayerPosition.y - draggedLayerTopLeftApexPosition.y)
+            touchPositionY = otherLayerEdgeY
+            isYChanged = true
+        } else if draggedLayerRotation.isRightAngle,
+                  let otherLayerEdgeY = snappingIndex.nearestEdgeY(to: draggedLayerBottomRightApexPosition.y,
+                                                                  tolerance: dragGestureTolerance)
+        {
+            // bottom - bottom, bottom - top
+            newY = otherLayerEdgeY - (draggedLayerBottomRightApexPosition.y - newDraggedLayerPosition.y)
+            touchPositionY = otherLayerEdgeY
+            isYChanged = true
+        } else if let otherLayerCenterY = snappingIndex.nearestCenterY(to: newDraggedLayerPosition.y,
+                                                                       tolerance: dragGestureTolerance)
+        {
+            // centerY - centerY
+            newY = otherLayerCenterY
+            touchPositionY = otherLayerCenterY
+            isYChanged = true
         }
 
         // centerX - frameCenterX
@@ -32,19 +32,27 @@ struct ImageProjectLayerView: View {
                 .scaleEffect(x: layerModel.scaleX ?? 1.0, y: layerModel.scaleY ?? 1.0)
                 .rotationEffect(layerModel.rotation ?? .zero)
                 .position((layerModel.position ?? .zero) + vm.plane.globalPosition)
-                .opacity(vm.tools.layersOpacity)
+                .opacity(vm.tools.layersOpacity * layerModel.opacity)
+                .blendMode(layerModel.blendMode.blendMode)
                 .animation(.easeInOut(duration: 0.35), value: vm.tools.layersOpacity)
                 .onAppear {
                     layerModel.size = vm.calculateLayerSize(layerModel: layerModel)
                     vm.objectWillChange.send()
                 }
-                .onTapGesture {
+                .onTapGesture(coordinateSpace: .named(ImageProjectPlaneView.coordinateSpaceName)) { location in
+                    let tappedLayer = vm.hitTestLayer(at: location - vm.plane.globalPosition)
+
                     if let currentTool = vm.currentTool as? ProjectToolType,
                        currentTool == .merge
                     {
-                        vm.toggleToMergeStatus(layerModel: layerModel)
-                    } else {
-                        vm.toggleIsActiveStatus(layerModel: layerModel)
+                        guard let tappedLayer else { return }
+                        vm.toggleToMergeStatus(layerModel: tappedLayer)
+                    } else if let tappedLayer {
+                        vm.toggleIsActiveStatus(layerModel: tappedLayer)
+                    } else if let activeLayer = vm.activeLayer {
+                        // A tap through transparent pixels of every layer deselects instead of
+                        // picking the layer whose bounds happened to receive it.
+                        vm.toggleIsActiveStatus(layerModel: activeLayer)
                     }
                 }
                 .gesture(
@@ -8,6 +8,8 @@
 import SwiftUI
 
 struct ImageProjectPlaneView: View {
+    static let coordinateSpaceName = "ImageProjectPlane"
+
     @EnvironmentObject private var vm: ImageProjectViewModel
 
     @GestureState private var lastPosition: CGPoint?
@@ -46,7 +48,17 @@ struct ImageProjectPlaneView: View {
                 )
                 .zIndex(Double(layerModel.positionZ ?? 1))
             }
+
+            if vm.isColorSamplingActive {
+                Color.clear
+                    .contentShape(Rectangle())
+                    .zIndex(Double(Int.max))
+                    .onTapGesture(coordinateSpace: .named(ImageProjectPlaneView.coordinateSpaceName)) { location in
+                        vm.sampleProjectColor(at: location - vm.plane.globalPosition)
+                    }
+            }
         }
+        .coordinateSpace(name: ImageProjectPlaneView.coordinateSpaceName)
         .position(vm.plane.currentPosition ?? .zero)
         .onChange(of: vm.frame.rect) { frameViewRect in
             guard let frameViewRect, let workspaceSize = vm.workspaceSize else { return }
@@ -43,6 +43,7 @@ struct ImageProjectView: View {
                             ForEach(vm.layersToMerge) { layerModel in
                                 ImageProjectMergingFrameView(layerModel: layerModel)
                             }
+                            ImageProjectMergingBoundsView()
                         } else if let layerModel = vm.activeLayer, let positionZ = layerModel.positionZ, positionZ > 0 {
                             ImageProjectEditingFrameView(layerModel: layerModel)
                         }
@@ -0,0 +1,56 @@
+//
+//  ImageProjectToolCaseBlendView.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 19/07/2024.
+//
+
+import SwiftUI
+
+struct ImageProjectToolCaseBlendView: View {
+    @EnvironmentObject var vm: ImageProjectViewModel
+
+    var body: some View {
+        VStack {
+            if let layerModel = vm.activeLayer {
+                HStack {
+                    Text("Opacity")
+                        .foregroundStyle(Color(.tint))
+                    Slider(value: Binding(get: { layerModel.opacity },
+                                          set: { newValue in
+                                              layerModel.opacity = newValue
+                                              vm.objectWillChange.send()
+                                          }),
+                           in: 0.0 ... 1.0,
+                           onEditingChanged: { [unowned vm] editing in
+                               if !editing {
+                                   vm.updateLatestSnapshot()
+                               }
+                           })
+                    Text("\(Int((layerModel.opacity * 100.0).rounded()))%")
+                        .foregroundStyle(Color(.tint))
+                        .frame(minWidth: 50)
+                }
+                .padding(.horizontal)
+            }
+
+            ScrollView(.horizontal, showsIndicators: false) {
+                HStack {
+                    ForEach(BlendModeType.allCases) { blendMode in
+                        ImageProjectToolTileView(title: blendMode.name)
+                            .opacity(vm.activeLayer?.blendMode == blendMode ? 1.0 : 0.5)
+                            .contentShape(Rectangle())
+                            .onTapGesture {
+                                guard let layerModel = vm.activeLayer,
+                                      layerModel.blendMode != blendMode else { return }
+
+                                layerModel.blendMode = blendMode
+                                vm.updateLatestSnapshot()
+                            }
+                    }
+                    Spacer()
+                }
+            }
+        }
+    }
+}
@@ -31,7 +31,9 @@ struct ImageProjectDrawingCanvasView: View {
     var body: some View {
         ZStack {
             ForEach(vm.drawings + [vm.currentDrawing], id: \.self) { drawing in
-                let strokeStyle = StrokeStyle(lineWidth: CGFloat(drawing.currentPencilSize), lineCap: .round)
+                let strokeStyle = StrokeStyle(lineWidth: CGFloat(drawing.currentPencilSize),
+                                              lineCap: .round,
+                                              lineJoin: .round)
 
                 Path { path in
                     drawing.setupPath(&path)
@@ -68,7 +70,7 @@ struct ImageProjectDrawingCanvasView: View {
                             y: pencilPosition.y
                                 - initialOffset.height
                         )
-                    vm.currentDrawing.particlesPositions.append(particlePosition)
+                    vm.appendDrawingParticle(particlePosition, frameSize: frameSize)
                     if vm.currentDrawing.currentPencilType == .pen {
                         vm.storePenPointSnapshot()
                     }
@@ -80,7 +82,7 @@ struct ImageProjectDrawingCanvasView: View {
             guard newValue != .pen else { return }
             vm.endPenPath()
         }
-        .onChange(of: vm.currentDrawing.particlesPositions.isEmpty) { [unowned vm] _ in
+        .onChange(of: vm.currentDrawing.stroke.isEmpty) { [unowned vm] _ in
             vm.setupRightButtonActionForPen()
         }
         .onReceive(vm.floatingButtonClickedSubject) { action in
@@ -96,7 +98,7 @@ struct ImageProjectDrawingCanvasView: View {
                 vm.currentTool = .none
                 vm.currentColorPickerType = .none
                 vm.drawings.removeAll()
-                vm.currentDrawing.particlesPositions.removeAll()
+                vm.currentDrawing.stroke.removeAll()
             } else if action == .endPenPath {
                 vm.endPenPath()
             }
@@ -51,21 +51,21 @@ struct ImageProjectToolCaseFiltersView: View {
         }
         .onAppear {
             guard let activeLayer = vm.activeLayer else { return }
-            vm.originalCGImage = activeLayer.cgImage?.copy()
+            vm.originalCGImage = activeLayer.cgImage
         }
         .onReceive(vm.floatingButtonClickedSubject) { [unowned vm] actionType in
-            guard let activeLayer = vm.activeLayer else { return }
+            guard vm.activeLayer != nil else { return }
             if actionType == .backToCategories {
                 vm.disablePreviewCGImage()
                 vm.currentCategory = .none
                 vm.currentFilter = .none
             } else if actionType == .confirm {
+                if let currentFilter = vm.currentFilter {
+                    vm.commitFilter(currentFilter)
+                }
                 vm.currentTool = .none
                 vm.currentCategory = .none
                 vm.currentFilter = .none
-                Task {
-                    try? await vm.saveNewCGImageOnDisk(fileName: activeLayer.fileName, cgImage: activeLayer.cgImage)
-                }
                 vm.updateLatestSnapshot()
             }
         }
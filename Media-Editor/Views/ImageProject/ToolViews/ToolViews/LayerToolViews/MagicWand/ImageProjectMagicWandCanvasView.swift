@@ -50,16 +50,14 @@ struct ImageProjectMagicWandCanvasView: View {
             )
             .onAppear {
                 guard let activeLayer = vm.activeLayer else { return }
-                vm.originalCGImage = activeLayer.cgImage?.copy()
+                vm.originalCGImage = activeLayer.cgImage
             }
             .onReceive(vm.floatingButtonClickedSubject) { action in
                 if action == .confirm {
                     guard let activeLayer = vm.activeLayer else { return }
                     vm.currentTool = .none
                     vm.currentColorPickerType = .none
-                    Task {
-                        try await vm.saveNewCGImageOnDisk(fileName: activeLayer.fileName, cgImage: activeLayer.cgImage)
-                    }
+                    vm.commitCheckpoint(of: activeLayer)
                     vm.updateLatestSnapshot()
                     vm.leftFloatingButtonActionType = .back
 
@@ -0,0 +1,33 @@
+//
+//  ImageProjectMergingBoundsView.swift
+//  Media-Editor
+//
+//  Created by Łukasz Bielawski on 19/07/2024.
+//
+
+import SwiftUI
+
+struct ImageProjectMergingBoundsView: View {
+    @EnvironmentObject var vm: ImageProjectViewModel
+
+    var body: some View {
+        if vm.layersToMerge.count > 1,
+           let mergedLayersBounds = vm.mergedLayersBounds,
+           let planeCurrentPosition = vm.plane.currentPosition,
+           let workspaceSize = vm.workspaceSize,
+           let planeScale = vm.plane.scale
+        {
+            Rectangle()
+                .stroke(Color(.accent), style: StrokeStyle(lineWidth: 1, dash: [6, 4]))
+                .frame(width: mergedLayersBounds.width * planeScale,
+                       height: mergedLayersBounds.height * planeScale)
+                .position(CGPoint(
+                    x: (mergedLayersBounds.midX + planeCurrentPosition.x) * planeScale
+                        - workspaceSize.width * 0.5 * (planeScale - 1.0),
+                    y: (mergedLayersBounds.midY + planeCurrentPosition.y) * planeScale
+                        - workspaceSize.height * 0.5 * (planeScale - 1.0)
+                ))
+                .allowsHitTesting(false)
+        }
+    }
+}
@@ -59,6 +59,11 @@ struct ImageProjectToolDetailsView: View {
                             .onAppear {
                                 vm.leftFloatingButtonActionType = .back
                             }
+                    case .blend:
+                        ImageProjectToolCaseBlendView()
+                            .onAppear {
+                                vm.leftFloatingButtonActionType = .back
+                            }
                     case .crop:
                         ImageProjectToolCaseCropView()
                             .onAppear {
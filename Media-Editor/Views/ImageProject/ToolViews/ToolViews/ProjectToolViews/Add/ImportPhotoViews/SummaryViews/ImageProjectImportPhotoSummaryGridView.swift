@@ -39,6 +39,20 @@ struct ImageProjectImportPhotoSummaryGridView: View {
                 }
             }
 
+            Image(systemName: vm.isDownsamplingImports
+                ? "arrow.down.right.and.arrow.up.left"
+                : "arrow.up.left.and.arrow.down.right")
+                .font(.title3)
+                .foregroundStyle(Color(.tint))
+                .frame(width: tileWidth, height: tileWidth)
+                .background {
+                    Circle().fill(Color(.image))
+                }.onTapGesture {
+                    vm.isDownsamplingImports.toggle()
+                    HapticService.shared.play(.light)
+                }
+                .padding(.vertical, padding * tileWidth)
+
             Image(systemName: "plus")
                 .font(.title)
                 .foregroundStyle(Color(.tint))
@@ -20,7 +20,7 @@ struct ImageProjectToolCaseLayerBackgroundView: View {
         }
         .onAppear {
             guard let activeLayer = vm.activeLayer else { return }
-            vm.originalCGImage = activeLayer.cgImage?.copy()
+            vm.originalCGImage = activeLayer.cgImage
         }.onReceive(vm.floatingButtonClickedSubject) { [unowned vm] action in
             if action == .back {
                 vm.activeLayer?.cgImage = vm.originalCGImage
@@ -83,17 +83,15 @@ struct ImageProjectTextSliderView: View {
                     vm.objectWillChange.send()
                     return value
                 }
-                .throttleAndDebounce(throttleInterval: .seconds(0.0333),
-                                     debounceInterval: .seconds(1.0),
-                                     scheduler: DispatchQueue.main)
-                .sink { [unowned vm] sender, publisherType in
-
-                    vm.renderTask?.cancel()
-                    vm.renderTask = Task { [unowned vm] in
-                        try await vm.renderTextLayer()
-                    }
-                    if publisherType == .debounce && sender != .textField {
-                        vm.updateLatestSnapshot()
+                .coalescedPerFrame(settleInterval: 1.0, label: hint)
+                .sink { [unowned vm] sender, phase in
+                    if phase == .frame {
+                        vm.scheduleTextLayerRender()
+                    } else {
+                        vm.persistTextLayer()
+                        if sender != .textField {
+                            vm.updateLatestSnapshot()
+                        }
                     }
                     vm.objectWillChange.send()
                 }
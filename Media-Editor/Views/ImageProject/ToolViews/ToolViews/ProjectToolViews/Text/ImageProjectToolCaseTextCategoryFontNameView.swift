@@ -52,10 +52,7 @@ struct ImageProjectToolCaseTextCategoryFontNameView: View {
         .onAppear {
             cancellable = debounceSaveSubject
                 .sink { [unowned vm] in
-                    vm.renderTask?.cancel()
-                    vm.renderTask = Task {
-                        try await vm.renderTextLayer()
-                    }
+                    vm.scheduleTextLayerRender(isSavingToDisk: true)
                     vm.updateLatestSnapshot()
                     vm.objectWillChange.send()
                 }
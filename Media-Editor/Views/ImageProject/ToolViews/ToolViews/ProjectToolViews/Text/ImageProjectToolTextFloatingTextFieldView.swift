@@ -54,13 +54,12 @@ struct ImageProjectToolTextFloatingTextFieldView: View {
         .onAppear {
             cancellable =
                 debounceTextFieldSubject
-                    .throttleAndDebounce(throttleInterval: .seconds(0.0333),
-                                         debounceInterval: .seconds(1.0),
-                                         scheduler: DispatchQueue.main)
-                    .sink { [unowned vm] _ in
-                        vm.renderTask?.cancel()
-                        vm.renderTask = Task {
-                            try await vm.renderTextLayer()
+                    .coalescedPerFrame(settleInterval: 1.0, label: "Text field")
+                    .sink { [unowned vm] _, phase in
+                        if phase == .frame {
+                            vm.scheduleTextLayerRender()
+                        } else {
+                            vm.persistTextLayer()
                         }
                         vm.objectWillChange.send()
                     }
@@ -77,7 +77,7 @@ struct ImageProjectToolGradientPickerView: View {
                 ShapeStyleModel(shapeStyle: gradient,
                                 shapeStyleCG: gradientCG)
             if let colorPickerType = vm.currentColorPickerType {
-                vm.performColorPickedAction(colorPickerType, .debounce)
+                vm.performColorPickedAction(colorPickerType)
             }
         }
     }
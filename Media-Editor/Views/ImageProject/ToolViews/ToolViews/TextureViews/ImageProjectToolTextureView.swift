@@ -41,6 +41,13 @@ struct ImageProjectToolTextureView: View {
                            let colorPickerType = vm.currentColorPickerType
                         {
                             ImageProjectToolColorPickerView(colorPickerBinding: colorPickerBinding.onChange(colorPicked), customTitle: customTitle, allowOpacity: allowOpacity)
+                            if colorPickerType.allowsProjectSampling {
+                                ImageProjectToolTileView(title: "Sample", systemName: "eyedropper")
+                                    .opacity(vm.isColorSamplingActive ? 1.0 : 0.6)
+                                    .onTapGesture {
+                                        vm.isColorSamplingActive.toggle()
+                                    }
+                            }
                             if colorPickerType.pickerType == .gradient {
                                 ImageProjectToolTileView(title: "Gradient", iconName: "gradient")
                                     .onTapGesture {
@@ -53,7 +60,7 @@ struct ImageProjectToolTextureView: View {
                                         .onTapGesture { [unowned vm] in
                                             vm.currentShapeStyleModel =
                                                 ShapeStyleModel(shapeStyle: color, shapeStyleCG: color.cgColor)
-                                            vm.performColorPickedAction(colorPickerType, .debounce)
+                                            vm.performColorPickedAction(colorPickerType)
                                         }
                                 }
                             }
@@ -72,9 +79,9 @@ struct ImageProjectToolTextureView: View {
 
                 cancellable =
                     colorPickerSubject
-                        .throttleAndDebounce(throttleInterval: .seconds(1.0), debounceInterval: .seconds(1.0), scheduler: DispatchQueue.main)
-                        .sink { [unowned vm] colorPickerType, throttleAndDebounceType in
-                            vm.performColorPickedAction(colorPickerType, throttleAndDebounceType)
+                        .coalescedPerFrame(settleInterval: 1.0, label: "Color picker")
+                        .sink { [unowned vm] colorPickerType, phase in
+                            vm.performColorPickedAction(colorPickerType, phase)
                         }
             }
         }
@@ -84,6 +91,7 @@ struct ImageProjectToolTextureView: View {
             vm.leftFloatingButtonActionType = .backFromColorPicker
         }
         .onDisappear {
+            vm.isColorSamplingActive = false
             if let onDisappearAction {
                 vm.leftFloatingButtonActionType = onDisappearAction
             }